@@ -0,0 +1,841 @@
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <optional>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <string>
+#include <vector>
+#include "days/day14/day14.h"
+#include "days/day14/bit_field.h"
+#include "days/day14/sparse_field.h"
+#include "days/day14/tilt_kernel.h"
+#include "days/day16/day16.h"
+#include "days/day16/beam_trace.h"
+#include "days/day16/incremental_beams.h"
+#include "days/day16/splitter_graph.h"
+#include "days/day17/axis_graph.h"
+#include "days/day17/day17.h"
+#include "days/day17/delta_stepping.h"
+#include "utils/bench_utils.h"
+#include "utils/file_utils.h"
+#include "utils/mapped_lines.h"
+#include "utils/perf_counters.h"
+#include "utils/thread_pool.h"
+
+using aoc2024::utils::time_ms;
+using aoc2024::utils::random_grid;
+
+namespace {
+    struct Benchmark {
+        const char *name;
+
+        /// grid edge length used when none is given on the command line
+        size_t default_size;
+        std::function<void(size_t)> run;
+    };
+
+    std::vector<std::string> day14_grid(size_t size) {
+        return random_grid(size, size, ".O#", {0.7, 0.2, 0.1});
+    }
+
+    void bench_day14_bitfield(size_t size) {
+        using namespace aoc2024::day14;
+        const auto in = day14_grid(size);
+        Field field = Field::parse(in);
+        BitField bits = BitField::from_field(field);
+        constexpr size_t cycles = 3;
+        constexpr TiltDir spin[] = {TiltDir::NORTH, TiltDir::WEST, TiltDir::SOUTH, TiltDir::EAST};
+
+        const double field_ms = time_ms([&] {
+            for (size_t i = 0; i < cycles; ++i) {
+                for (const auto dir: spin) {
+                    field.tilt(dir);
+                }
+            }
+        });
+        const double bits_ms = time_ms([&] {
+            for (size_t i = 0; i < cycles; ++i) {
+                for (const auto dir: spin) {
+                    bits.tilt(dir);
+                }
+            }
+        });
+
+        const bool same = bits.to_field().to_string() == field.to_string();
+        printf("day14 %zux%zu, %zu spin cycles: Field %.2f ms, BitField %.2f ms (x%.1f) %s\n",
+               size, size, cycles, field_ms, bits_ms, field_ms / bits_ms, same ? "OK" : "MISMATCH");
+    }
+
+    /***
+     * one spin cycle with 1..N threads on grids from 1024 up to `max_size` (doubling)
+     */
+    void bench_day14_parallel(size_t max_size) {
+        using namespace aoc2024::day14;
+        const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<size_t> thread_counts;
+        for (size_t threads = 1; threads < cores; threads *= 2) {
+            thread_counts.push_back(threads);
+        }
+        thread_counts.push_back(cores);
+        constexpr TiltDir spin[] = {TiltDir::NORTH, TiltDir::WEST, TiltDir::SOUTH, TiltDir::EAST};
+        for (size_t size = 1024; size <= max_size; size *= 2) {
+            const Field start = Field::parse(day14_grid(size));
+            Field reference = start;
+            const double serial_ms = time_ms([&] { reference.spin_cycle(); });
+            printf("day14 %zux%zu spin cycle: serial tilt %.2f ms\n", size, size, serial_ms);
+            for (const size_t threads: thread_counts) {
+                aoc2024::utils::ThreadPool pool(threads);
+                Field field = start;
+                const double ms = time_ms([&] {
+                    for (const auto dir: spin) {
+                        field.tilt(dir, pool);
+                    }
+                });
+                const bool same = field.hash() == reference.hash() && field == reference;
+                printf("  %2zu threads: %.2f ms (x%.1f) %s\n", threads, ms, serial_ms / ms, same ? "OK" : "MISMATCH");
+            }
+        }
+    }
+
+    /***
+     * one spin cycle with the different layouts, with L1 / LLC misses if perf counters are available
+     */
+    void bench_day14_layout(size_t size) {
+        using namespace aoc2024::day14;
+        // counters first, so they are inherited by the workers of the pool
+        aoc2024::utils::PerfCounters counters;
+        aoc2024::utils::ThreadPool pool;
+        const Field start = Field::parse(day14_grid(size));
+        Field reference = start;
+        reference.spin_cycle(pool);
+
+        const auto measure = [&](const char *name, const std::function<void(Field &)> &spin) {
+            Field field = start;
+            counters.start();
+            const double ms = time_ms([&] { spin(field); });
+            counters.stop();
+            const bool same = field.hash() == reference.hash() && field == reference;
+            if (counters.available()) {
+                printf("  %-28s %9.2f ms  L1D misses %12llu  LLC misses %11llu %s\n", name, ms,
+                       static_cast<unsigned long long>(counters.l1_misses()),
+                       static_cast<unsigned long long>(counters.llc_misses()), same ? "OK" : "MISMATCH");
+            } else {
+                printf("  %-28s %9.2f ms  (no perf counters) %s\n", name, ms, same ? "OK" : "MISMATCH");
+            }
+        };
+
+        printf("day14 %zux%zu spin cycle, %zu threads\n", size, size, pool.size());
+        measure("move() based tilt", [](Field &field) { field.spin_cycle(); });
+        measure("row major", [&](Field &field) {
+            for (const auto dir: {TiltDir::NORTH, TiltDir::WEST, TiltDir::SOUTH, TiltDir::EAST}) {
+                field.tilt(dir, pool);
+            }
+        });
+        measure("column major", [&](Field &field) {
+            field.set_layout(Layout::COLUMN_MAJOR, &pool);
+            for (const auto dir: {TiltDir::NORTH, TiltDir::WEST, TiltDir::SOUTH, TiltDir::EAST}) {
+                field.tilt(dir, pool);
+            }
+            field.set_layout(Layout::ROW_MAJOR, &pool);
+        });
+        measure("switching (all stride-1)", [&](Field &field) { field.spin_cycle(pool); });
+    }
+
+    /***
+     * spin cycles of the (parallel, stride-1) dense field against the sparse one for different stone densities
+     */
+    void bench_day14_sparse(size_t size) {
+        using namespace aoc2024::day14;
+        aoc2024::utils::ThreadPool pool;
+        constexpr size_t cycles = 5;
+        for (const double stones: {0.01, 0.05, 0.1, 0.3}) {
+            const auto in = random_grid(size, size, ".O#", {0.9 - stones, stones, 0.1});
+            Field field = Field::parse(in);
+            SparseField sparse = SparseField::from_field(field);
+            const double field_ms = time_ms([&] {
+                for (size_t i = 0; i < cycles; ++i) {
+                    field.spin_cycle(pool);
+                }
+            });
+            const double sparse_ms = time_ms([&] {
+                for (size_t i = 0; i < cycles; ++i) {
+                    sparse.spin_cycle();
+                }
+            });
+            const bool same = sparse.hash() == field.hash() && sparse.to_field() == field;
+            printf("day14 %zux%zu, %2.0f%% stones, %zu spin cycles: Field %.2f ms, SparseField %.2f ms (x%.1f) %s\n",
+                   size, size, stones * 100, cycles, field_ms, sparse_ms, field_ms / sparse_ms,
+                   same ? "OK" : "MISMATCH");
+        }
+    }
+
+    /***
+     * EAST / WEST tilts on a row-major field (stride-1 rows) with every tilt kernel the CPU supports
+     */
+    void bench_day14_kernel(size_t size) {
+        using namespace aoc2024::day14;
+        aoc2024::utils::ThreadPool pool(1);
+        constexpr size_t rounds = 10;
+        const Field start = Field::parse(day14_grid(size));
+        const auto previous = tilt_kernel();
+
+        const auto run = [&](TiltKernel kernel, Field &field) {
+            set_tilt_kernel(kernel);
+            return time_ms([&] {
+                for (size_t i = 0; i < rounds; ++i) {
+                    field.tilt(i % 2 == 0 ? TiltDir::EAST : TiltDir::WEST, pool);
+                }
+            });
+        };
+
+        Field scalar = start;
+        const double scalar_ms = run(TiltKernel::SCALAR, scalar);
+        printf("day14 %zux%zu, %zu row tilts: scalar %.2f ms\n", size, size, rounds, scalar_ms);
+        if (tilt_kernel_supported(TiltKernel::AVX2)) {
+            Field avx2 = start;
+            const double avx2_ms = run(TiltKernel::AVX2, avx2);
+            const bool same = avx2.hash() == scalar.hash() && avx2 == scalar;
+            printf("  AVX2 %.2f ms (x%.1f) %s\n", avx2_ms, scalar_ms / avx2_ms, same ? "OK" : "MISMATCH");
+        } else {
+            printf("  AVX2 not supported by this CPU\n");
+        }
+        set_tilt_kernel(previous);
+    }
+
+    /***
+     * 1000 independent size x size grids solved by [day14_batch] with 1..N threads
+     */
+    void bench_day14_batch(size_t size) {
+        using namespace aoc2024::day14;
+        constexpr size_t grids = 1000;
+        std::string input;
+        for (size_t i = 0; i < grids; ++i) {
+            for (const auto &line: random_grid(size, size, ".O#", {0.7, 0.2, 0.1}, i)) {
+                input += line;
+                input += '\n';
+            }
+            input += '\n';
+        }
+
+        const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        std::vector<GridAnswer> reference;
+        for (size_t threads = 1;; threads = std::min(cores, threads * 2)) {
+            aoc2024::utils::ThreadPool pool(threads);
+            std::istringstream stream(input);
+            const auto result = day14_batch(stream, pool);
+            if (reference.empty()) {
+                reference = result.answers;
+            }
+            const bool same = std::equal(reference.begin(), reference.end(), result.answers.begin(),
+                                         result.answers.end(), [](const auto &a, const auto &b) {
+                        return a.part1 == b.part1 && a.part2 == b.part2;
+                    });
+            printf("day14 batch of %zu %zux%zu grids, %2zu threads: %.2f s, %.0f grids/s %s\n", result.answers.size(),
+                   size, size, threads, result.seconds, result.grids_per_second(), same ? "OK" : "MISMATCH");
+            if (threads == cores) {
+                break;
+            }
+        }
+    }
+
+    std::vector<std::string> day16_grid(size_t size) {
+        return random_grid(size, size, "./\\-|", {0.9, 0.025, 0.025, 0.025, 0.025});
+    }
+
+    /***
+     * the border start energizing the most (most of them leave the field right away on random grids)
+     */
+    aoc2024::day16::Beam day16_busiest_start(const aoc2024::day16::Field &field) {
+        using namespace aoc2024::day16;
+        Beam start{};
+        size_t best = 0;
+        const SplitterGraph graph(field);
+        for (const auto &beam: edge_beams(field.width(), field.height())) {
+            if (const size_t energy = graph.energy_level(beam); energy >= best) {
+                best = energy;
+                start = beam;
+            }
+        }
+        return start;
+    }
+
+    /***
+     * beams from the first few cells of the left border: frame by frame ([move_beams]) against [propagate]
+     */
+    void bench_day16_propagate(size_t size) {
+        using namespace aoc2024::day16;
+        const Field start = Field::parse(day16_grid(size));
+        constexpr size_t starts = 10;
+        double frames_ms = 0;
+        double jumps_ms = 0;
+        size_t energy = 0;
+        bool same = true;
+        for (size_t y = 0; y < std::min(starts, size); ++y) {
+            const Beam beam{.x = 0, .y = y, .dir = Direction::RIGHT};
+            Field frames = start;
+            Field jumps = start;
+            frames_ms += time_ms([&] {
+                frames.add_beam(beam);
+                while (frames.has_beams()) {
+                    frames.move_beams();
+                }
+            });
+            jumps_ms += time_ms([&] { jumps.propagate(beam); });
+            energy += jumps.energy_level();
+            same = same && frames.to_visited_map_string() == jumps.to_visited_map_string();
+        }
+        printf("day16 %zux%zu, %zu starts, energy %zu: move_beams %.2f ms, propagate %.2f ms (x%.1f) %s\n", size,
+               size, starts, energy, frames_ms, jumps_ms, frames_ms / jumps_ms, same ? "OK" : "MISMATCH");
+    }
+
+    /***
+     * part 2 (all border starts): re-simulating every start against the condensed splitter graph
+     */
+    void bench_day16_edges(size_t size) {
+        using namespace aoc2024::day16;
+        Field field = Field::parse(day16_grid(size));
+        const auto starts = edge_beams(size, size);
+
+        std::vector<size_t> simulated;
+        const double simulate_ms = time_ms([&] {
+            for (const auto &beam: starts) {
+                field.reset();
+                field.propagate(beam);
+                simulated.push_back(field.energy_level());
+            }
+        });
+
+        std::vector<size_t> looked_up;
+        double build_ms = 0;
+        double lookup_ms = 0;
+        size_t components = 0;
+        size_t bitsets = 0;
+        build_ms = time_ms([&] {
+            const SplitterGraph graph(field);
+            components = graph.component_count();
+            bitsets = graph.bitset_count();
+            lookup_ms = time_ms([&] {
+                for (const auto &beam: starts) {
+                    looked_up.push_back(graph.energy_level(beam));
+                }
+            });
+        });
+        build_ms -= lookup_ms;
+
+        printf("day16 %zux%zu, %zu starts: propagate %.2f ms, splitter graph %.2f ms build (%zu components, %zu"
+               " bitsets) + %.2f ms lookups (x%.1f) %s\n", size, size, starts.size(), simulate_ms, build_ms, components,
+               bitsets, lookup_ms, simulate_ms / (build_ms + lookup_ms), simulated == looked_up ? "OK" : "MISMATCH");
+    }
+
+    /***
+     * all border starts simulated on their own ([Field::energy_levels]) with 1..N threads
+     */
+    void bench_day16_parallel(size_t size) {
+        using namespace aoc2024::day16;
+        const Field field = Field::parse(day16_grid(size));
+        const auto starts = edge_beams(size, size);
+
+        const SplitterGraph graph(field);
+        std::vector<size_t> reference;
+        for (const auto &beam: starts) {
+            reference.push_back(graph.energy_level(beam));
+        }
+
+        const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        double single_ms = 0;
+        for (size_t threads = 1;; threads = std::min(cores, threads * 2)) {
+            aoc2024::utils::ThreadPool pool(threads);
+            std::vector<size_t> levels;
+            const double ms = time_ms([&] { levels = field.energy_levels(starts, pool); });
+            if (threads == 1) {
+                single_ms = ms;
+            }
+            printf("day16 %zux%zu, %zu starts, %2zu threads: %.2f ms (x%.1f) %s\n", size, size, starts.size(),
+                   threads, ms, single_ms / ms, levels == reference ? "OK" : "MISMATCH");
+            if (threads == cores) {
+                break;
+            }
+        }
+    }
+
+    /***
+     * 100 random single cell edits: [IncrementalBeams::set] against setting the cell and propagating again
+     */
+    void bench_day16_incremental(size_t size) {
+        using namespace aoc2024::day16;
+        constexpr size_t edits = 100;
+        Field field = Field::parse(day16_grid(size));
+
+        const Beam start = day16_busiest_start(field);
+
+        double build_ms = 0;
+        std::optional<IncrementalBeams> incremental;
+        build_ms = time_ms([&] { incremental.emplace(field, start); });
+
+        std::mt19937_64 rng(42);
+        double incremental_ms = 0;
+        double rerun_ms = 0;
+        size_t changed = 0;
+        bool same = true;
+        for (size_t i = 0; i < edits; ++i) {
+            const size_t x = rng() % size;
+            const size_t y = rng() % size;
+            const auto type = static_cast<FieldType>(rng() % 5);
+            incremental_ms += time_ms([&] { incremental->set(x, y, type); });
+            changed += incremental->last_changed();
+            rerun_ms += time_ms([&] {
+                field.set(x, y, type);
+                field.reset();
+                field.propagate(start);
+            });
+            same = same && field.energy_level() == incremental->energy_level();
+        }
+        printf("day16 %zux%zu, %zu edits: build %.2f ms, incremental %.2f ms (%zu nodes changed per edit),"
+               " propagate again %.2f ms (x%.1f) %s\n", size, size, edits, build_ms, incremental_ms,
+               changed / edits, rerun_ms, rerun_ms / incremental_ms, same ? "OK" : "MISMATCH");
+    }
+
+    /***
+     * frame by frame beams from the busiest border start with and without a trace; then the last and the middle
+     * frame rebuilt from the trace
+     */
+    void bench_day16_trace(size_t size) {
+        using namespace aoc2024::day16;
+        const Field start = Field::parse(day16_grid(size));
+        const Beam beam = day16_busiest_start(start);
+        const auto run = [&](Field &field) {
+            field.add_beam(beam);
+            while (field.has_beams()) {
+                field.move_beams();
+            }
+        };
+
+        Field plain = start;
+        const double plain_ms = time_ms([&] { run(plain); });
+
+        const auto path = (std::filesystem::temp_directory_path() / "aoc2024_day16.trace").string();
+        Field traced = start;
+        size_t records = 0;
+        double traced_ms = 0;
+        {
+            BeamTraceWriter writer(path, traced);
+            traced.trace(&writer);
+            traced_ms = time_ms([&] { run(traced); });
+            traced.trace(nullptr);
+            records = writer.records();
+        }
+
+        const auto reader = BeamTraceReader::open(path);
+        if (!reader.has_value()) {
+            return;
+        }
+        std::string last_map;
+        std::string middle;
+        const Field field = reader->field();
+        const double last_ms = time_ms([&] { last_map = field.energy_map(reader->frame(reader->frames())); });
+        const double middle_ms = time_ms([&] { middle = field.to_string(reader->frame(reader->frames() / 2)); });
+        std::filesystem::remove(path);
+
+        printf("day16 %zux%zu, %u frames, %zu events: move_beams %.2f ms, traced %.2f ms (+%.0f%%), last frame"
+               " %.2f ms, middle frame %.2f ms %s\n", size, size, reader->frames(), records, plain_ms, traced_ms,
+               100 * (traced_ms - plain_ms) / plain_ms, last_ms, middle_ms,
+               last_map == plain.energy_map() && !middle.empty() ? "OK" : "MISMATCH");
+    }
+
+    std::vector<std::string> day17_grid(size_t size) {
+        return random_grid(size, size, "123456789", std::vector<double>(9, 1.0));
+    }
+
+    /***
+     * both parts from the top left corner with the binary heap against the bucket queue
+     */
+    void bench_day17_queue(size_t size) {
+        using namespace aoc2024::day17;
+        Field field = Field::parse(day17_grid(size));
+        const PathDescriptor start{.x = 0, .y = 0, .straight_move_count = 0, .dir = Direction::RIGHT,
+                                   .accumulated_heat = 0};
+        for (const bool second_task: {false, true}) {
+            size_t heap = 0;
+            size_t buckets = 0;
+            field.reset();
+            const double heap_ms = time_ms([&] { heap = field.do_steps(start, second_task, QueueKind::BINARY_HEAP); });
+            field.reset();
+            const double buckets_ms = time_ms([&] { buckets = field.do_steps(start, second_task, QueueKind::BUCKETS); });
+            printf("day17 %zux%zu part %d, heat %zu, state %.1f MB: priority_queue %.2f ms, buckets %.2f ms (x%.2f)"
+                   " %s\n", size, size, second_task ? 2 : 1, buckets, field.visited().bytes() / 1e6, heap_ms,
+                   buckets_ms, heap_ms / buckets_ms, heap == buckets ? "OK" : "MISMATCH");
+        }
+    }
+
+    /***
+     * both parts with 32 byte PathDescriptors against 8 byte packed paths, each in the heap and in the bucket queue
+     */
+    void bench_day17_packed(size_t size) {
+        using namespace aoc2024::day17;
+        Field field = Field::parse(day17_grid(size));
+        const PathDescriptor start{.x = 0, .y = 0, .straight_move_count = 0, .dir = Direction::RIGHT,
+                                   .accumulated_heat = 0};
+        for (const bool second_task: {false, true}) {
+            size_t heat[4] = {};
+            double ms[4] = {};
+            const QueueKind kinds[4] = {QueueKind::BINARY_HEAP, QueueKind::PACKED_HEAP, QueueKind::BUCKETS,
+                                        QueueKind::PACKED_BUCKETS};
+            for (size_t i = 0; i < 4; ++i) {
+                field.reset();
+                ms[i] = time_ms([&] { heat[i] = field.do_steps(start, second_task, kinds[i]); });
+            }
+            const bool same = heat[0] == heat[1] && heat[0] == heat[2] && heat[0] == heat[3];
+            printf("day17 %zux%zu part %d, heat %zu, entry %zu -> %zu bytes: priority_queue %.2f -> %.2f ms (x%.2f),"
+                   " buckets %.2f -> %.2f ms (x%.2f) %s\n", size, size, second_task ? 2 : 1, heat[0],
+                   sizeof(PathDescriptor), sizeof(uint64_t), ms[0], ms[1], ms[0] / ms[1], ms[2], ms[3], ms[2] / ms[3],
+                   same ? "OK" : "MISMATCH");
+        }
+    }
+
+    /***
+     * both parts on the task input and a synthetic grid: moves looked up in the std::maps against the constexpr
+     * arrays, as time per expanded state
+     */
+    void bench_day17_moves(size_t size) {
+        using namespace aoc2024::day17;
+        const PathDescriptor start{.x = 0, .y = 0, .straight_move_count = 0, .dir = Direction::RIGHT,
+                                   .accumulated_heat = 0};
+        const std::pair<const char *, std::vector<std::string>> inputs[] = {
+                {"task", aoc2024::utils::load_day(17, aoc2024::utils::RIDDLE_TYPE::TASK)},
+                {"synthetic", day17_grid(size)},
+        };
+        for (const auto &[name, input]: inputs) {
+            Field field = Field::parse(input);
+            for (const auto rules: {CRUCIBLE, ULTRA_CRUCIBLE}) {
+                size_t map = 0;
+                size_t array = 0;
+                field.reset();
+                const double map_ms = time_ms([&] { map = field.do_steps(start, rules, QueueKind::BUCKETS,
+                                                                          MoveTable::MAP); });
+                field.reset();
+                const double array_ms = time_ms([&] { array = field.do_steps(start, rules, QueueKind::BUCKETS,
+                                                                              MoveTable::ARRAY); });
+                const double expanded = static_cast<double>(field.last_expanded());
+                printf("day17 %s %zux%zu rules %zu..%zu, heat %zu, %.0f states expanded: std::map %.1f ns,"
+                       " array %.1f ns per state (x%.2f) %s\n", name, field.width(), field.height(),
+                       rules.min_straight, rules.max_straight, array, expanded, map_ms * 1e6 / expanded,
+                       array_ms * 1e6 / expanded, map_ms / array_ms, map == array ? "OK" : "MISMATCH");
+            }
+        }
+    }
+
+    /***
+     * both parts: the field by field search (best of starting right and down, as the crucible may do either)
+     * against the axis graph
+     */
+    void bench_day17_axis(size_t size) {
+        using namespace aoc2024::day17;
+        Field field = Field::parse(day17_grid(size));
+        const size_t target = size * size - 1;
+        for (const auto rules: {CRUCIBLE, ULTRA_CRUCIBLE}) {
+            const bool second_task = rules.max_straight == ULTRA_CRUCIBLE.max_straight;
+            size_t steps = SIZE_MAX;
+            const double steps_ms = time_ms([&] {
+                for (const auto dir: {Direction::RIGHT, Direction::DOWN}) {
+                    field.reset();
+                    const PathDescriptor start{.x = 0, .y = 0, .straight_move_count = 0, .dir = dir,
+                                               .accumulated_heat = 0};
+                    steps = std::min(steps, field.do_steps(start, second_task) - field.get(0, 0).heat_loss);
+                }
+            });
+            uint32_t axis = 0;
+            double search_ms = 0;
+            const double axis_ms = time_ms([&] {
+                AxisGraph graph(field, rules);
+                search_ms = time_ms([&] { axis = graph.min_heat_loss(0, target); });
+            });
+            printf("day17 %zux%zu rules %zu..%zu, heat %u: do_steps %.2f ms, axis graph %.2f ms (search %.2f ms,"
+                   " x%.1f) %s\n", size, size, rules.min_straight, rules.max_straight, axis, steps_ms, axis_ms,
+                   search_ms, steps_ms / axis_ms, steps == axis ? "OK" : "MISMATCH");
+        }
+    }
+
+    /***
+     * rules read at run time against the search specialized for them (checked against the axis graph)
+     */
+    void bench_day17_rules(size_t size) {
+        using namespace aoc2024::day17;
+        Field field = Field::parse(day17_grid(size));
+        const PathDescriptor start{.x = 0, .y = 0, .straight_move_count = 0, .dir = Direction::RIGHT,
+                                   .accumulated_heat = 0};
+        for (const auto rules: {CrucibleRules{1, 3}, CrucibleRules{4, 10}, CrucibleRules{2, 7}}) {
+            size_t generic = 0;
+            size_t specialized = 0;
+            field.reset();
+            const double generic_ms = time_ms([&] { generic = field.do_steps_generic(start, rules); });
+            field.reset();
+            const double specialized_ms = time_ms([&] { specialized = field.do_steps(start, rules); });
+            AxisGraph graph(field, rules);
+            const size_t axis = graph.min_heat_loss(0, size * size - 1) + field.get(0, 0).heat_loss;
+            printf("day17 %zux%zu rules %zu..%zu, heat %zu: generic %.2f ms, specialized %.2f ms (x%.2f) %s\n", size,
+                   size, rules.min_straight, rules.max_straight, specialized, generic_ms, specialized_ms,
+                   generic_ms / specialized_ms, generic == specialized && specialized == axis ? "OK" : "MISMATCH");
+        }
+    }
+
+    /***
+     * axis graph from corner to corner with Dijkstra against A* (heuristic built once per target, timed apart)
+     */
+    void bench_day17_astar(size_t size) {
+        using namespace aoc2024::day17;
+        const Field field = Field::parse(day17_grid(size));
+        const size_t target = size * size - 1;
+        for (const auto rules: {CRUCIBLE, ULTRA_CRUCIBLE}) {
+            AxisGraph graph(field, rules);
+            uint32_t reference = 0;
+            const double dijkstra_ms = time_ms([&] { reference = graph.min_heat_loss(0, target); });
+            const size_t dijkstra_expanded = graph.last_expanded();
+            printf("day17 %zux%zu rules %zu..%zu, heat %u: dijkstra %.2f ms (%zu expanded)", size, size,
+                   rules.min_straight, rules.max_straight, reference, dijkstra_ms, dijkstra_expanded);
+            for (const auto &[heuristic, name]: {std::pair{Heuristic::MANHATTAN, "manhattan"},
+                                                std::pair{Heuristic::REVERSE_DIJKSTRA, "reverse dijkstra"}}) {
+                uint32_t heat = 0;
+                AxisGraph fresh(field, rules);
+                // the first search for a target builds the bound, the second one reuses it
+                const double first_ms = time_ms([&] { heat = fresh.min_heat_loss(0, target, heuristic); });
+                const double search_ms = time_ms([&] { heat = fresh.min_heat_loss(0, target, heuristic); });
+                printf(", %s %.2f ms + %.2f ms bound (%zu expanded, %.1f%%) %s", name, search_ms,
+                       first_ms - search_ms, fresh.last_expanded(), 100.0 * fresh.last_expanded() / dijkstra_expanded,
+                       heat == reference ? "OK" : "MISMATCH");
+            }
+            printf("\n");
+        }
+    }
+
+    /***
+     * random pairs from one end / both ends, then many targets of one source: a search per target against one
+     * heat map
+     */
+    void bench_day17_targets(size_t size) {
+        using namespace aoc2024::day17;
+        const Field field = Field::parse(day17_grid(size));
+        AxisGraph graph(field, ULTRA_CRUCIBLE);
+        std::mt19937_64 rng(42);
+        std::uniform_int_distribution<size_t> pick(0, size * size - 1);
+
+        constexpr size_t pairs = 20;
+        double single_ms = 0;
+        double both_ms = 0;
+        size_t single_expanded = 0;
+        size_t both_expanded = 0;
+        bool same = true;
+        for (size_t i = 0; i < pairs; ++i) {
+            const size_t from = pick(rng);
+            const size_t to = pick(rng);
+            uint32_t single = 0;
+            uint32_t both = 0;
+            single_ms += time_ms([&] { single = graph.min_heat_loss(from, to); });
+            single_expanded += graph.last_expanded();
+            both_ms += time_ms([&] { both = graph.min_heat_loss_bidirectional(from, to); });
+            both_expanded += graph.last_expanded();
+            same = same && single == both;
+        }
+        printf("day17 %zux%zu, %zu pairs: one end %.2f ms (%zu expanded), both ends %.2f ms (%zu expanded, x%.2f) %s\n",
+               size, size, pairs, single_ms, single_expanded, both_ms, both_expanded, single_ms / both_ms,
+               same ? "OK" : "MISMATCH");
+
+        constexpr size_t targets = 100;
+        const size_t from = pick(rng);
+        std::vector<uint32_t> searched;
+        std::vector<size_t> to(targets);
+        std::generate(to.begin(), to.end(), [&] { return pick(rng); });
+        const double searches_ms = time_ms([&] {
+            for (const auto target: to) {
+                searched.push_back(graph.min_heat_loss(from, target));
+            }
+        });
+        std::vector<uint32_t> map;
+        const double map_ms = time_ms([&] { map = graph.heat_map(from); });
+        same = true;
+        for (size_t i = 0; i < targets; ++i) {
+            same = same && map[to[i]] == searched[i];
+        }
+        printf("day17 %zux%zu, %zu targets: one search each %.2f ms, heat map %.2f ms (x%.1f) %s\n", size, size,
+               targets, searches_ms, map_ms, searches_ms / map_ms, same ? "OK" : "MISMATCH");
+    }
+
+    /***
+     * the best route from corner to corner and the 10 best ones (Yen) with the memory the graph keeps for them
+     */
+    void bench_day17_routes(size_t size) {
+        using namespace aoc2024::day17;
+        const Field field = Field::parse(day17_grid(size));
+        const size_t target = size * size - 1;
+        AxisGraph graph(field, ULTRA_CRUCIBLE);
+        // whether the route is one the crucible can drive and costs what it claims
+        const auto drivable = [&](const Route &route) {
+            uint32_t heat = 0;
+            const auto fields = graph.fields_of(route);
+            for (size_t i = 1; i < fields.size(); ++i) {
+                heat += field.get(fields[i] % size, fields[i] / size).heat_loss;
+            }
+            for (size_t i = 1; i < route.stops.size(); ++i) {
+                const size_t a = route.stops[i - 1];
+                const size_t b = route.stops[i];
+                const size_t run = a / size == b / size ? (a > b ? a - b : b - a) : (a > b ? a - b : b - a) / size;
+                const bool turned = i == 1 || (route.stops[i - 2] / size == a / size) != (a / size == b / size);
+                if (run < ULTRA_CRUCIBLE.min_straight || run > ULTRA_CRUCIBLE.max_straight || !turned) {
+                    return false;
+                }
+            }
+            return heat == route.heat && fields.front() == 0 && fields.back() == target;
+        };
+
+        uint32_t heat = 0;
+        const double heat_ms = time_ms([&] { heat = graph.min_heat_loss(0, target); });
+        std::optional<Route> best;
+        const double route_ms = time_ms([&] { best = graph.min_heat_route(0, target); });
+        printf("day17 %zux%zu, heat %u: heat only %.2f ms, best route %.2f ms (%zu stops, %zu fields) %s\n", size, size,
+               heat, heat_ms, route_ms, best->stops.size(), graph.fields_of(best.value()).size(),
+               best->heat == heat && drivable(best.value()) ? "OK" : "MISMATCH");
+
+        constexpr size_t k = 10;
+        std::vector<Route> routes;
+        const double routes_ms = time_ms([&] { routes = graph.k_min_heat_routes(0, target, k); });
+        bool ok = routes.size() == k && routes.front().heat == heat;
+        std::string heats;
+        for (size_t i = 0; i < routes.size(); ++i) {
+            ok = ok && drivable(routes[i]) && (i == 0 || routes[i - 1].heat <= routes[i].heat);
+            heats += (i == 0 ? "" : " ") + std::to_string(routes[i].heat);
+        }
+        // a route from a field to itself is only the one without moves
+        const auto standing = graph.k_min_heat_routes(target, target, k);
+        ok = ok && standing.size() == 1 && standing.front().heat == 0 &&
+             standing.front().stops == std::vector<size_t>{target};
+        size_t route_bytes = 0;
+        for (const auto &route: routes) {
+            route_bytes += route.stops.capacity() * sizeof(size_t);
+        }
+        printf("day17 %zux%zu, %zu best routes (%s): %.2f ms, graph %.1f MB (%.1f bytes per field), routes %zu bytes"
+               " %s\n", size, size, k, heats.c_str(), routes_ms, graph.bytes() / 1e6,
+               static_cast<double>(graph.bytes()) / (size * size), route_bytes, ok ? "OK" : "MISMATCH");
+    }
+
+    /***
+     * heat maps (4..10 rules) on a quarter, half and the full size: the serial search against delta-stepping with
+     * 1..N threads
+     */
+    void bench_day17_parallel(size_t size) {
+        using namespace aoc2024::day17;
+        const size_t cores = std::max(1u, std::thread::hardware_concurrency());
+        for (const size_t edge: {size / 4, size / 2, size}) {
+            const Field field = Field::parse(day17_grid(edge));
+            AxisGraph graph(field, ULTRA_CRUCIBLE);
+            std::vector<uint32_t> reference;
+            const double serial_ms = time_ms([&] { reference = graph.heat_map(0); });
+            printf("day17 %zux%zu, serial: %.2f ms\n", edge, edge, serial_ms);
+            for (size_t threads = 1;; threads = std::min(cores, threads * 2)) {
+                aoc2024::utils::ThreadPool pool(threads);
+                DeltaStepping stepping(graph, pool);
+                std::vector<uint32_t> map;
+                const double ms = time_ms([&] { map = stepping.heat_map(0); });
+                printf("day17 %zux%zu, delta %u, %2zu threads: %.2f ms, %zu rounds (x%.2f of serial) %s\n", edge, edge,
+                       stepping.delta(), threads, ms, stepping.last_rounds(), serial_ms / ms,
+                       map == reference ? "OK" : "MISMATCH");
+                if (threads == cores) {
+                    break;
+                }
+            }
+        }
+    }
+
+    /***
+     * a day 17 grid loaded from a file and parsed: read line by line into strings against parsed straight from the
+     * mapped file (both from the page cache, the file was just written)
+     */
+    void bench_load_mapped(size_t size) {
+        using namespace aoc2024::day17;
+        const auto path = (std::filesystem::temp_directory_path() / "aoc2024_day17.txt").string();
+        {
+            std::ofstream out(path);
+            for (const auto &line: day17_grid(size)) {
+                out << line << '\n';
+            }
+        }
+
+        Field read;
+        double read_lines_ms = 0;
+        const double read_ms = time_ms([&] {
+            std::vector<std::string> lines;
+            read_lines_ms = time_ms([&] { lines = aoc2024::utils::read_file_lines(path); });
+            read = Field::parse(lines);
+        });
+        Field mapped;
+        double mapped_lines_ms = 0;
+        size_t bytes = 0;
+        const double mapped_ms = time_ms([&] {
+            std::optional<aoc2024::utils::MappedLines> lines;
+            mapped_lines_ms = time_ms([&] { lines = aoc2024::utils::MappedLines::open(path); });
+            if (lines.has_value()) {
+                mapped = Field::parse(lines->lines());
+                bytes = lines->bytes();
+            }
+        });
+        std::filesystem::remove(path);
+
+        bool same = read.width() == mapped.width() && read.height() == mapped.height();
+        for (size_t y = 0; same && y < read.height(); ++y) {
+            for (size_t x = 0; x < read.width(); ++x) {
+                same = same && read.get(x, y).heat_loss == mapped.get(x, y).heat_loss;
+            }
+        }
+        printf("load %zux%zu (%.1f MB): read_file_lines %.2f ms + parse = %.2f ms, mapped %.2f ms + parse = %.2f ms"
+               " (x%.2f) %s\n", size, size, bytes / 1e6, read_lines_ms, read_ms, mapped_lines_ms, mapped_ms,
+               read_ms / mapped_ms, same ? "OK" : "MISMATCH");
+    }
+
+    const std::vector<Benchmark> benchmarks = {
+            {"day14_bitfield", 1000, bench_day14_bitfield},
+            {"day14_parallel", 4096, bench_day14_parallel},
+            {"day14_layout", 4096, bench_day14_layout},
+            {"day14_sparse", 2048, bench_day14_sparse},
+            {"day14_kernel", 4096, bench_day14_kernel},
+            {"day14_batch", 100, bench_day14_batch},
+            {"day16_propagate", 1000, bench_day16_propagate},
+            {"day16_edges", 300, bench_day16_edges},
+            {"day16_parallel", 300, bench_day16_parallel},
+            {"day16_incremental", 1000, bench_day16_incremental},
+            {"day16_trace", 1000, bench_day16_trace},
+            {"day17_queue", 300, bench_day17_queue},
+            {"day17_packed", 300, bench_day17_packed},
+            {"day17_moves", 1000, bench_day17_moves},
+            {"day17_axis", 300, bench_day17_axis},
+            {"day17_rules", 300, bench_day17_rules},
+            {"day17_astar", 1000, bench_day17_astar},
+            {"day17_targets", 500, bench_day17_targets},
+            {"day17_routes", 300, bench_day17_routes},
+            {"day17_parallel", 2000, bench_day17_parallel},
+            {"load_mapped", 4000, bench_load_mapped},
+    };
+}
+
+/***
+ * Usage: aoc2024_bench [name] [size]
+ * Runs all benchmarks (or only the one with the given name) on a synthetic size x size grid.
+ */
+int main(int argc, char **argv) {
+    const std::string filter = argc > 1 ? argv[1] : "";
+    const size_t size = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 0;
+    bool found = false;
+    for (const auto &benchmark: benchmarks) {
+        if (!filter.empty() && filter != benchmark.name) {
+            continue;
+        }
+        found = true;
+        benchmark.run(size > 0 ? size : benchmark.default_size);
+    }
+    if (!found) {
+        fprintf(stderr, "Unknown benchmark %s\n", filter.c_str());
+        return 1;
+    }
+    return 0;
+}
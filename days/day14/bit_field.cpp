@@ -0,0 +1,140 @@
+#include "bit_field.h"
+#include "bit_line.h"
+#include <algorithm>
+#include <bit>
+
+namespace aoc2024::day14 {
+    namespace {
+        using bits::WORD_BITS;
+        using bits::tilt_line;
+
+        /***
+         * @brief transposes the set bits of `lines` (n_lines * words_per_line) into `out`
+         * (which has `out_words` words per line)
+         */
+        void transpose_bits(const std::vector<uint64_t> &lines, size_t n_lines, size_t words_per_line,
+                            std::vector<uint64_t> &out, size_t out_words) {
+            std::fill(out.begin(), out.end(), 0);
+            for (size_t line = 0; line < n_lines; ++line) {
+                for (size_t w = 0; w < words_per_line; ++w) {
+                    uint64_t word = lines[line * words_per_line + w];
+                    while (word != 0) {
+                        const size_t pos = w * WORD_BITS + std::countr_zero(word);
+                        out[pos * out_words + line / WORD_BITS] |= uint64_t{1} << (line % WORD_BITS);
+                        word &= word - 1;
+                    }
+                }
+            }
+        }
+    }
+
+    BitField::BitField(size_t width, size_t height) : m_width(width), m_height(height) {
+        m_row_words = (width + WORD_BITS - 1) / WORD_BITS;
+        m_col_words = (height + WORD_BITS - 1) / WORD_BITS;
+        m_row_rocks = std::vector<uint64_t>(m_row_words * height);
+        m_row_stones = std::vector<uint64_t>(m_row_words * height);
+        m_col_rocks = std::vector<uint64_t>(m_col_words * width);
+        m_col_stones = std::vector<uint64_t>(m_col_words * width);
+    }
+
+    BitField BitField::from_field(const Field &field) {
+        BitField bits(field.width(), field.height());
+        for (size_t y = 0; y < field.height(); ++y) {
+            for (size_t x = 0; x < field.width(); ++x) {
+                const uint64_t row_bit = uint64_t{1} << (x % WORD_BITS);
+                const uint64_t col_bit = uint64_t{1} << (y % WORD_BITS);
+                const size_t row_idx = y * bits.m_row_words + x / WORD_BITS;
+                const size_t col_idx = x * bits.m_col_words + y / WORD_BITS;
+                switch (field.get(x, y)) {
+                    case FieldType::MOVEABLE_STONE:
+                        bits.m_row_stones[row_idx] |= row_bit;
+                        bits.m_col_stones[col_idx] |= col_bit;
+                        break;
+                    case FieldType::FIXED_STONE:
+                        bits.m_row_rocks[row_idx] |= row_bit;
+                        bits.m_col_rocks[col_idx] |= col_bit;
+                        break;
+                    case FieldType::FREE:
+                        break;
+                }
+            }
+        }
+        return bits;
+    }
+
+    Field BitField::to_field() const {
+        sync_rows();
+        Field field(m_width, m_height);
+        for (size_t y = 0; y < m_height; ++y) {
+            for (size_t x = 0; x < m_width; ++x) {
+                const size_t idx = y * m_row_words + x / WORD_BITS;
+                const uint64_t bit = uint64_t{1} << (x % WORD_BITS);
+                if (m_row_rocks[idx] & bit) {
+                    field.set(x, y, FieldType::FIXED_STONE);
+                } else if (m_row_stones[idx] & bit) {
+                    field.set(x, y, FieldType::MOVEABLE_STONE);
+                } else {
+                    field.set(x, y, FieldType::FREE);
+                }
+            }
+        }
+        return field;
+    }
+
+    void BitField::sync_rows() const {
+        if (m_rows_valid) {
+            return;
+        }
+        transpose_bits(m_col_stones, m_width, m_col_words, m_row_stones, m_row_words);
+        m_rows_valid = true;
+    }
+
+    void BitField::sync_cols() const {
+        if (m_cols_valid) {
+            return;
+        }
+        transpose_bits(m_row_stones, m_height, m_row_words, m_col_stones, m_col_words);
+        m_cols_valid = true;
+    }
+
+    void BitField::tilt(TiltDir dir) {
+        switch (dir) {
+            case TiltDir::NORTH:
+            case TiltDir::SOUTH: {
+                sync_cols();
+                const bool towards_start = dir == TiltDir::NORTH;
+                for (size_t x = 0; x < m_width; ++x) {
+                    tilt_line(&m_col_stones[x * m_col_words], &m_col_rocks[x * m_col_words], m_height,
+                              towards_start);
+                }
+                m_rows_valid = false;
+                break;
+            }
+
+            case TiltDir::EAST:
+            case TiltDir::WEST: {
+                sync_rows();
+                const bool towards_start = dir == TiltDir::WEST;
+                for (size_t y = 0; y < m_height; ++y) {
+                    tilt_line(&m_row_stones[y * m_row_words], &m_row_rocks[y * m_row_words], m_width,
+                              towards_start);
+                }
+                m_cols_valid = false;
+                break;
+            }
+        }
+    }
+
+    std::size_t BitField::sum_field() const {
+        sync_rows();
+        size_t score = 0;
+        for (size_t y = 0; y < m_height; ++y) {
+            size_t stones = 0;
+            for (size_t w = 0; w < m_row_words; ++w) {
+                stones += std::popcount(m_row_stones[y * m_row_words + w]);
+            }
+            score += stones * (m_height - y);
+        }
+        return score;
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef AOC2024_DAY14_BIT_FIELD_H
+#define AOC2024_DAY14_BIT_FIELD_H
+
+#include <cstdint>
+#include <vector>
+#include "day14.h"
+
+namespace aoc2024::day14 {
+
+    /***
+     * @brief Bit packed representation of a [Field]
+     *
+     * Moveable stones and fixed stones are stored as bitsets (`uint64_t` words) twice:
+     * once per row (used by EAST / WEST tilts) and once per column (used by NORTH / SOUTH tilts).
+     * A tilt then does not move stones cell by cell anymore: for every segment between two fixed stones
+     * we count the stones (popcount) and fill that many bits at the side we tilt to.
+     *
+     * Only the layout that was tilted last holds the current stones, the other one is rebuilt
+     * lazily (in O(words + stones)) when it is needed.
+     */
+    class BitField {
+    public:
+        /***
+         * @brief Builds the bit representation from a normal [Field]
+         * @param field
+         * @return
+         */
+        static BitField from_field(const Field &field);
+
+        /***
+         * @brief Converts back into a normal [Field] (mainly to compare against it)
+         * @return
+         */
+        [[nodiscard]] Field to_field() const;
+
+        /***
+         * @brief Tilts the field in a direction (same semantics as [Field::tilt])
+         * @param dir
+         */
+        void tilt(TiltDir dir);
+
+        /***
+         * @brief Returns the sum of the field (same semantics as [Field::sum_field])
+         * @return
+         */
+        [[nodiscard]] std::size_t sum_field() const;
+
+        [[nodiscard]] inline size_t width() const {
+            return m_width;
+        }
+
+        [[nodiscard]] inline size_t height() const {
+            return m_height;
+        }
+
+    private:
+        BitField(size_t width, size_t height);
+
+        void sync_rows() const;
+
+        void sync_cols() const;
+
+        size_t m_width = 0;
+        size_t m_height = 0;
+
+        /// words per row (ceil(width / 64)) and per column (ceil(height / 64))
+        size_t m_row_words = 0;
+        size_t m_col_words = 0;
+
+        /// rocks never change, so both layouts are always valid
+        std::vector<uint64_t> m_row_rocks;
+        std::vector<uint64_t> m_col_rocks;
+
+        /// stones in both layouts; only one of them is up to date (see flags below)
+        mutable std::vector<uint64_t> m_row_stones;
+        mutable std::vector<uint64_t> m_col_stones;
+        mutable bool m_rows_valid = true;
+        mutable bool m_cols_valid = true;
+    };
+}
+
+#endif //AOC2024_DAY14_BIT_FIELD_H
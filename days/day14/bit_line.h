@@ -0,0 +1,70 @@
+#ifndef AOC2024_DAY14_BIT_LINE_H
+#define AOC2024_DAY14_BIT_LINE_H
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include "../../utils/bit_line.h"
+
+/***
+ * Tilting lines of cells stored as bits (see [utils::bits])
+ */
+namespace aoc2024::day14::bits {
+    using utils::bits::WORD_BITS;
+    using utils::bits::word_mask;
+    using utils::bits::count_bits;
+    using utils::bits::clear_bits;
+    using utils::bits::set_bits;
+
+    /***
+     * @brief tilts one line (row or column) of `n` cells
+     *
+     * every segment between two rocks gets its stones counted and refilled at the
+     * lower (`towards_start`) or upper end of the segment
+     */
+    inline void tilt_line(uint64_t *stones, const uint64_t *rocks, size_t n, bool towards_start) {
+        // compacts the segment [start, end)
+        const auto tilt_segment = [&](size_t start, size_t end) {
+            if (end <= start) {
+                return;
+            }
+            if ((end - 1) / WORD_BITS == start / WORD_BITS) {
+                // most segments fit into one word
+                const size_t w = start / WORD_BITS;
+                const size_t from = start % WORD_BITS;
+                const size_t to = (end - 1) % WORD_BITS + 1;
+                const uint64_t mask = word_mask(from, to);
+                const uint64_t segment = stones[w] & mask;
+                if (segment != 0) {
+                    const auto count = static_cast<size_t>(std::popcount(segment));
+                    const uint64_t filled = towards_start ? word_mask(from, from + count) : word_mask(to - count, to);
+                    stones[w] = (stones[w] & ~mask) | filled;
+                }
+                return;
+            }
+            const size_t count = count_bits(stones, start, end);
+            if (count > 0) {
+                clear_bits(stones, start, end);
+                if (towards_start) {
+                    set_bits(stones, start, start + count);
+                } else {
+                    set_bits(stones, end - count, end);
+                }
+            }
+        };
+
+        // walk the rocks word by word, every rock ends a segment
+        size_t start = 0;
+        const size_t words = (n + WORD_BITS - 1) / WORD_BITS;
+        for (size_t w = 0; w < words; ++w) {
+            for (uint64_t word = rocks[w]; word != 0; word &= word - 1) {
+                const size_t rock = w * WORD_BITS + std::countr_zero(word);
+                tilt_segment(start, rock);
+                start = rock + 1;
+            }
+        }
+        tilt_segment(start, n);
+    }
+}
+
+#endif //AOC2024_DAY14_BIT_LINE_H
@@ -3,9 +3,13 @@
 //
 
 #include "day14.h"
+#include "sparse_field.h"
+#include "tilt_kernel.h"
+#include <bit>
+#include <chrono>
+#include <iterator>
 #include "ranges"
 #include "map"
-#include "set"
 
 namespace aoc2024::day14 {
     inline std::optional<std::pair<size_t, size_t>> Field::move(size_t x, size_t y, TiltDir dir, bool keep_moving) {
@@ -74,7 +78,7 @@ namespace aoc2024::day14 {
         return false;
     }
 
-    inline void Field::tilt(TiltDir dir) {
+    void Field::tilt(TiltDir dir) {
         // move from the direction we move TO backwards
         // e.g., NORTH means we start at the bottom of the field and move up line by line
         // if we find a stone we move it down as far as we can and continue
@@ -122,6 +126,172 @@ namespace aoc2024::day14 {
 
     }
 
+    uint64_t Field::tilt_lines(size_t line_begin, size_t line_end, TiltDir dir) {
+        const bool vertical = dir == TiltDir::NORTH || dir == TiltDir::SOUTH;
+        const bool towards_start = dir == TiltDir::NORTH || dir == TiltDir::WEST;
+        const size_t length = vertical ? m_height : m_width;
+
+        // both the memory index and the row-major (hash) index of cell `pos` in line `line` are linear:
+        // index = line * line_step + first + pos * pos_step (pos counts cells from the side we tilt to)
+        const auto layout_steps = [&](size_t x_step, size_t y_step) {
+            const auto line_step = static_cast<ptrdiff_t>(vertical ? x_step : y_step);
+            const auto along_step = static_cast<ptrdiff_t>(vertical ? y_step : x_step);
+            const auto first = towards_start ? 0 : static_cast<ptrdiff_t>(length - 1) * along_step;
+            return std::tuple{line_step, first, towards_start ? along_step : -along_step};
+        };
+        const auto [line_step, first, pos_step] = m_layout == Layout::ROW_MAJOR
+                                                  ? layout_steps(1, m_width) : layout_steps(m_height, 1);
+        const auto [key_line_step, key_first, key_pos_step] = layout_steps(1, m_width);
+
+        uint64_t hash_delta = 0;
+        FieldType *const cells = m_field.data();
+        // `free` is the pos where the next stone of this line lands
+        const auto visit = [&](ptrdiff_t line, ptrdiff_t pos, size_t &free) {
+            FieldType &cell = cells[line * line_step + first + pos * pos_step];
+            switch (cell) {
+                case FieldType::FIXED_STONE:
+                    free = pos + 1;
+                    break;
+                case FieldType::MOVEABLE_STONE:
+                    if (free != static_cast<size_t>(pos)) {
+                        const auto target = static_cast<ptrdiff_t>(free);
+                        cells[line * line_step + first + target * pos_step] = FieldType::MOVEABLE_STONE;
+                        cell = FieldType::FREE;
+                        const ptrdiff_t key_base = line * key_line_step + key_first;
+                        hash_delta ^= zobrist_key(key_base + target * key_pos_step) ^
+                                      zobrist_key(key_base + pos * key_pos_step);
+                    }
+                    ++free;
+                    break;
+                case FieldType::FREE:
+                    break;
+            }
+        };
+
+        const auto n = static_cast<ptrdiff_t>(length);
+        const auto begin = static_cast<ptrdiff_t>(line_begin);
+        const auto end = static_cast<ptrdiff_t>(line_end);
+        const bool contiguous = vertical == (m_layout == Layout::COLUMN_MAJOR);
+        if (contiguous) {
+            // the line is one run of memory (pos_step is +-1), which the (SIMD) kernel handles on its own
+            std::vector<uint64_t> changed;
+            for (ptrdiff_t line = begin; line < end; ++line) {
+                const ptrdiff_t low = line * line_step + std::min(first, first + (n - 1) * pos_step);
+                tilt_run(cells + low, length, towards_start, changed);
+                const ptrdiff_t key_base = line * key_line_step + key_first;
+                for (size_t w = 0; w < changed.size(); ++w) {
+                    for (uint64_t word = changed[w]; word != 0; word &= word - 1) {
+                        // memory offset -> pos (counted from the side we tilt to)
+                        const auto offset = static_cast<ptrdiff_t>(w * 64 + std::countr_zero(word));
+                        const ptrdiff_t pos = towards_start ? offset : n - 1 - offset;
+                        hash_delta ^= zobrist_key(key_base + pos * key_pos_step);
+                    }
+                }
+            }
+        } else {
+            std::vector<size_t> next_free(line_end - line_begin, 0);
+            for (ptrdiff_t pos = 0; pos < n; ++pos) {
+                for (ptrdiff_t line = begin; line < end; ++line) {
+                    visit(line, pos, next_free[line - begin]);
+                }
+            }
+        }
+        return hash_delta;
+    }
+
+    void Field::tilt(TiltDir dir, utils::ThreadPool &pool) {
+        constexpr size_t cache_line = 64;
+        constexpr size_t cells_per_line = std::max<size_t>(1, cache_line / sizeof(FieldType));
+        const bool vertical = dir == TiltDir::NORTH || dir == TiltDir::SOUTH;
+        const bool contiguous = vertical == (m_layout == Layout::COLUMN_MAJOR);
+        const size_t lines = vertical ? m_width : m_height;
+
+        // a few blocks per worker so the faster ones can pick up the rest
+        const size_t blocks = pool.size() * 4;
+        size_t grain = std::max<size_t>(1, (lines + blocks - 1) / blocks);
+        if (!contiguous) {
+            grain = std::max(cells_per_line, (grain + cells_per_line - 1) / cells_per_line * cells_per_line);
+        }
+
+        std::atomic<uint64_t> hash_delta = 0;
+        pool.parallel_for(lines, grain, [&](size_t begin, size_t end, size_t) {
+            hash_delta.fetch_xor(tilt_lines(begin, end, dir));
+        });
+        m_hash ^= hash_delta;
+    }
+
+    void Field::set_layout(Layout layout, utils::ThreadPool *pool) {
+        if (layout == m_layout) {
+            return;
+        }
+
+        // the source has `rows` lines of `cols` cells, the result is its transpose
+        const size_t rows = m_layout == Layout::ROW_MAJOR ? m_height : m_width;
+        const size_t cols = m_layout == Layout::ROW_MAJOR ? m_width : m_height;
+        std::pmr::vector<FieldType> transposed(m_field.size(), m_field.get_allocator());
+
+        // tiles small enough that source and target lines of one tile stay in L1
+        constexpr size_t tile = 32;
+        const auto transpose_tiles = [&](size_t tile_row_begin, size_t tile_row_end, size_t) {
+            for (size_t r0 = tile_row_begin * tile; r0 < std::min(rows, tile_row_end * tile); r0 += tile) {
+                for (size_t c0 = 0; c0 < cols; c0 += tile) {
+                    const size_t r1 = std::min(rows, r0 + tile);
+                    const size_t c1 = std::min(cols, c0 + tile);
+                    for (size_t r = r0; r < r1; ++r) {
+                        for (size_t c = c0; c < c1; ++c) {
+                            transposed[c * rows + r] = m_field[r * cols + c];
+                        }
+                    }
+                }
+            }
+        };
+
+        const size_t tile_rows = (rows + tile - 1) / tile;
+        if (pool != nullptr) {
+            pool->parallel_for(tile_rows, 1, transpose_tiles);
+        } else {
+            transpose_tiles(0, tile_rows, 0);
+        }
+
+        m_field = std::move(transposed);
+        m_layout = layout;
+    }
+
+    void Field::spin_cycle(utils::ThreadPool &pool) {
+        set_layout(Layout::COLUMN_MAJOR, &pool);
+        tilt(TiltDir::NORTH, pool);
+        set_layout(Layout::ROW_MAJOR, &pool);
+        tilt(TiltDir::WEST, pool);
+        set_layout(Layout::COLUMN_MAJOR, &pool);
+        tilt(TiltDir::SOUTH, pool);
+        set_layout(Layout::ROW_MAJOR, &pool);
+        tilt(TiltDir::EAST, pool);
+    }
+
+    bool Field::operator==(const Field &other) const {
+        if (m_width != other.m_width || m_height != other.m_height) {
+            return false;
+        }
+        if (m_layout == other.m_layout) {
+            return m_field == other.m_field;
+        }
+        for (size_t y = 0; y < m_height; ++y) {
+            for (size_t x = 0; x < m_width; ++x) {
+                if (get(x, y) != other.get(x, y)) {
+                    return false;
+                }
+            }
+        }
+        return true;
+    }
+
+    void Field::spin_cycle() {
+        tilt(TiltDir::NORTH);
+        tilt(TiltDir::WEST);
+        tilt(TiltDir::SOUTH);
+        tilt(TiltDir::EAST);
+    }
+
     std::size_t Field::sum_field() const {
         size_t line = 0;
         size_t score = 0;
@@ -137,39 +307,50 @@ namespace aoc2024::day14 {
         return score;
     }
 
+    namespace {
+        template<typename Lines>
+        Field parse_lines(const Lines &in, std::pmr::memory_resource *memory) {
+            if (in.empty()) {
+                std::cerr << "Cannot parse empty field" << std::endl;
+                return {0, 0, memory};
+            }
+
+            const size_t height = in.size();
+            const size_t width = in[0].size();
+            Field field(width, height, memory);
+            size_t y = 0;
+            size_t x;
+            for (const auto &line: in) {
+                x = 0;
+                for (const char &chr: line) {
+                    switch (chr) {
+                        case '#':
+                            field.set(x, y, FieldType::FIXED_STONE);
+                            break;
+                        case 'O':
+                            field.set(x, y, FieldType::MOVEABLE_STONE);
+                            break;
+                        case '.':
+                            field.set(x, y, FieldType::FREE);
+                            break;
+                        default:
+                            std::cerr << "Unknown character " << chr << std::endl;
+                            break;
+                    }
+                    ++x;
+                }
+                ++y;
+            }
+            return field;
+        }
+    }
+
     Field Field::parse(const std::vector<std::string> &in) {
-        if (in.empty()) {
-            std::cerr << "Cannot parse empty field" << std::endl;
-            return {0, 0};
-        }
-
-        const size_t height = in.size();
-        const size_t width = in[0].size();
-        Field field(width, height);
-        size_t y = 0;
-        size_t x;
-        for (const auto &line: in) {
-            x = 0;
-            for (const char &chr: line) {
-                switch (chr) {
-                    case '#':
-                        field.set(x, y, FieldType::FIXED_STONE);
-                        break;
-                    case 'O':
-                        field.set(x, y, FieldType::MOVEABLE_STONE);
-                        break;
-                    case '.':
-                        field.set(x, y, FieldType::FREE);
-                        break;
-                    default:
-                        std::cerr << "Unknown character " << chr << std::endl;
-                        break;
-                }
-                ++x;
-            }
-            ++y;
-        }
-        return field;
+        return parse_lines(in, std::pmr::get_default_resource());
+    }
+
+    Field Field::parse(std::span<const std::string_view> in, std::pmr::memory_resource *memory) {
+        return parse_lines(in, memory);
     }
 
     int day14_1(const std::vector<std::string> &in) {
@@ -181,58 +362,75 @@ namespace aoc2024::day14 {
         return field.sum_field();
     }
 
-    int day14_2(const std::vector<std::string> &in) {
+    SpinCycle day14_spin_cycle(const std::vector<std::string> &in) {
+        // the sparse field spins in time proportional to the number of stones
+        SparseField field = SparseField::from_field(Field::parse(in));
+        return find_spin_cycle(field);
+    }
+
+    int day14_2(const std::vector<std::string> &in, size_t iterations) {
         // we cannot iterate 1000000000 times (takes too long)
         // so idea is that we search until we find a loop
         // after each loop, the result is the same like after the loop before
-        // until we find the loop, we have to first find a stable state (start of loop)
-
-        // this variable remembers the hashes of the fields we have seen
-        auto seen = std::set<std::string>();
-        Field field = Field::parse(in);
+        // since we remembered the load of every step until then, we can just look it up
+        return static_cast<int>(day14_spin_cycle(in).load_after(iterations));
+    }
 
-        // until we first find a repetitions
-        size_t loop_start = 0;
-
-        // from first to second repetition
-        size_t loop_size = 0;
-        for (size_t i = 0; i < 1000000000 /** we will skip most of this*/; ++i) {
-            // std::cout << i << std::endl;
-            // tilt in every direction
-            field.tilt(TiltDir::NORTH);
-            field.tilt(TiltDir::WEST);
-            field.tilt(TiltDir::SOUTH);
-            field.tilt(TiltDir::EAST);
-            const auto hash = field.hash();
-            if (seen.contains(hash)) { // seen already
-                if (loop_start == 0) {
-                    // we found this configuration for the first time
-                    // std::cout << "Found loop at " << i << std::endl;
-                    loop_start = i;
-                    seen.clear(); // we will start again until this happens again
-                } else {
-                    // we found the same configuration again
-
-                    // we know the loop size now
-                    loop_size = i - loop_start;
-                    // std::cout << "Found loop size " << loop_size << std::endl;
-
-                    // count how often we can put the loop into the remaining iterations
-                    const auto remainder = (1000000000 - i) / loop_size;
-                    // and skip
-                    i += remainder * loop_size;
-
-                    // just very negligible performance improvement
-                    seen.clear();
-                    // std::cout << " skip to " << i << std::endl;
-                    // std::cout << field.sum_field() << std::endl;
-                }
-            }
-            seen.insert(hash);
-            // std::cout << field.sum_field() << std::endl;
+    BatchResult day14_batch(std::istream &input, utils::ThreadPool &pool) {
+        // one buffer for the whole input, the grids are only views into it
+        const std::string buffer{std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>()};
+        std::vector<std::string_view> lines;
+        std::vector<std::pair<size_t, size_t>> grids; // [first line, end line)
+        size_t grid_start = 0;
+        for (size_t pos = 0; pos < buffer.size();) {
+            size_t end = buffer.find('\n', pos);
+            if (end == std::string::npos) {
+                end = buffer.size();
+            }
+            std::string_view line(buffer.data() + pos, end - pos);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            if (line.empty()) {
+                if (lines.size() > grid_start) {
+                    grids.emplace_back(grid_start, lines.size());
+                }
+                grid_start = lines.size();
+            } else {
+                lines.push_back(line);
+            }
+            pos = end + 1;
+        }
+        if (lines.size() > grid_start) {
+            grids.emplace_back(grid_start, lines.size());
         }
-        // field.print_field();
 
-        return field.sum_field();
+        BatchResult result{.answers = std::vector<GridAnswer>(grids.size()), .seconds = 0};
+
+        // one arena per worker for the parsed cells, the memory of the last grid is reused for the next one
+        // (the sparse field and the loop search still allocate from the heap)
+        constexpr size_t arena_size = 1 << 20;
+        std::vector<std::vector<std::byte>> arena_buffers(pool.size(), std::vector<std::byte>(arena_size));
+
+        const auto start = std::chrono::steady_clock::now();
+        pool.parallel_for(grids.size(), 1, [&](size_t begin, size_t end, size_t worker) {
+            std::pmr::monotonic_buffer_resource arena(arena_buffers[worker].data(), arena_size);
+            utils::ThreadPool inline_pool(1);
+            for (size_t i = begin; i < end; ++i) {
+                const auto grid = std::span(lines).subspan(grids[i].first, grids[i].second - grids[i].first);
+                {
+                    Field field = Field::parse(grid, &arena);
+                    SparseField sparse = SparseField::from_field(field);
+
+                    field.tilt(TiltDir::NORTH, inline_pool);
+                    result.answers[i].part1 = static_cast<int>(field.sum_field());
+                    result.answers[i].part2 = static_cast<int>(find_spin_cycle(sparse).load_after(1000000000));
+                }
+                arena.release();
+            }
+        });
+        const auto end = std::chrono::steady_clock::now();
+        result.seconds = std::chrono::duration<double>(end - start).count();
+        return result;
     }
 }
@@ -4,18 +4,27 @@
 
 #ifndef AOC2024_DAY14_H
 #define AOC2024_DAY14_H
+#include <cstdint>
 #include <memory>
+#include <memory_resource>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 #include <iostream>
+#include "../../utils/thread_pool.h"
 
 namespace aoc2024::day14 {
 
     /**
      * @brief The type of a field (see description of the riddle)
+     *
+     * Stored as one byte per cell, so a row can be compared 32 cells at a time (see [tilt_run])
      * @param field
      * @return
      */
-    enum class FieldType {
+    enum class FieldType : uint8_t {
         MOVEABLE_STONE,
         FIXED_STONE,
         FREE,
@@ -31,6 +40,33 @@ namespace aoc2024::day14 {
         WEST,
     };
 
+    /***
+     * @brief How the cells of a [Field] are laid out in memory
+     *
+     * A tilt walks along columns (NORTH / SOUTH) or rows (EAST / WEST), which is only stride-1
+     * if the layout matches the direction.
+     */
+    enum class Layout {
+        ROW_MAJOR,
+        COLUMN_MAJOR,
+    };
+
+    /***
+     * @brief Zobrist key of a cell (every moveable stone at that cell xors this into the hash)
+     *
+     * We derive the key from the cell index (splitmix64) instead of storing a random table,
+     * so copying a field stays as cheap as copying its cells.
+     *
+     * @param index y * width + x
+     * @return
+     */
+    inline uint64_t zobrist_key(size_t index) {
+        uint64_t z = static_cast<uint64_t>(index) + 0x9e3779b97f4a7c15ULL;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
     /***
      * @brief The field class (basically a x*y grid)
      */
@@ -43,6 +79,16 @@ namespace aoc2024::day14 {
          */
         static Field parse(const std::vector<std::string>& field);
 
+        /***
+         * @brief Parses a field from lines which are views into a bigger buffer
+         * @param field
+         * @param memory where the cells are allocated (e.g., an arena that is reused for many fields); only the
+         *        cells, copies of the field and anything built from it allocate from the default resource
+         * @return
+         */
+        static Field parse(std::span<const std::string_view> field,
+                           std::pmr::memory_resource *memory = std::pmr::get_default_resource());
+
         /***
          * @brief Checks if a stone can be moved in a direction
          * @param x
@@ -70,16 +116,65 @@ namespace aoc2024::day14 {
          */
         void tilt(TiltDir dir);
 
-        Field(size_t width, size_t height) : m_width(width), m_height(height) {
-            m_field = std::vector<FieldType>(width * height);
+        /***
+         * @brief Tilts the field in a direction using all workers of `pool`
+         *
+         * Columns (NORTH / SOUTH) or rows (EAST / WEST) do not influence each other, so every worker
+         * gets its own block of them. If the lines we tilt along are not contiguous in the current [Layout],
+         * blocks are a multiple of a cache line wide, so workers do not write into the same cache lines
+         * (as long as the lines start at a cache line).
+         *
+         * @param dir
+         * @param pool
+         */
+        void tilt(TiltDir dir, utils::ThreadPool &pool);
+
+        /***
+         * @brief One spin cycle (tilts NORTH, WEST, SOUTH and EAST)
+         */
+        void spin_cycle();
+
+        /***
+         * @brief One spin cycle where every tilt walks memory stride-1
+         *
+         * Switches to [Layout::COLUMN_MAJOR] before NORTH / SOUTH and back to [Layout::ROW_MAJOR] before
+         * WEST / EAST. Ends in [Layout::ROW_MAJOR].
+         *
+         * @param pool
+         */
+        void spin_cycle(utils::ThreadPool &pool);
+
+        [[nodiscard]] inline Layout layout() const {
+            return m_layout;
+        }
+
+        /***
+         * @brief Changes the memory layout (cache blocked transpose, no-op if it is the current one)
+         *
+         * The layout is invisible to everything but performance: [get], [set], [hash], ... behave the same.
+         *
+         * @param layout
+         * @param pool optional workers to split the transpose over
+         */
+        void set_layout(Layout layout, utils::ThreadPool *pool = nullptr);
+
+        Field(size_t width, size_t height, std::pmr::memory_resource *memory = std::pmr::get_default_resource())
+                : m_field(width * height, FieldType::FREE, memory), m_width(width), m_height(height) {
+            // an empty field has no moveable stones, so the hash starts at 0
         }
 
         [[nodiscard]] inline FieldType get(size_t x, size_t y) const {
-            return m_field[y * m_width + x];
+            return m_field[cell_index(x, y)];
         }
 
         inline void set(size_t x, size_t y, FieldType type) {
-            m_field[y * m_width + x] = type;
+            auto &cell = m_field[cell_index(x, y)];
+            // keep the hash up to date if a moveable stone appears or disappears
+            // (keys always use the row-major index, so the hash does not depend on the layout)
+            if ((cell == FieldType::MOVEABLE_STONE) != (type == FieldType::MOVEABLE_STONE)) {
+                m_hash ^= zobrist_key(y * m_width + x);
+            }
+            cell = type;
         }
 
         [[nodiscard]] inline size_t width() const {
@@ -141,19 +236,186 @@ namespace aoc2024::day14 {
         /***
          * @brief Returns a hash of the field so we can remember if we already seen it
          *
+         * The hash is a Zobrist hash over the moveable stones which is updated on every [set] (and therefore
+         * on every [move]), so asking for it is free. Equal hashes do not guarantee equal fields, use `==` for that.
+         *
          * @return
          */
-        [[nodiscard]] std::string hash() const {
-            return to_string();
+        [[nodiscard]] uint64_t hash() const {
+            return m_hash;
         }
+
+        [[nodiscard]] bool operator==(const Field &other) const;
     private:
-        std::vector<FieldType> m_field;
+        [[nodiscard]] inline size_t cell_index(size_t x, size_t y) const {
+            return m_layout == Layout::ROW_MAJOR ? y * m_width + x : x * m_height + y;
+        }
+
+        /***
+         * @brief Tilts the lines [line_begin, line_end) (columns for NORTH / SOUTH, rows for EAST / WEST)
+         *
+         * If the lines are not contiguous in memory we walk a whole block of them side by side
+         * (so we still stream through memory).
+         *
+         * @return the change of the hash (caller applies it, so workers do not fight over `m_hash`)
+         */
+        uint64_t tilt_lines(size_t line_begin, size_t line_end, TiltDir dir);
+
+        /// copies of a field allocate from the default resource again (not from the one of the original)
+        std::pmr::vector<FieldType> m_field;
+        Layout m_layout = Layout::ROW_MAJOR;
+
+        /// Zobrist hash of all moveable stones (see [hash])
+        uint64_t m_hash = 0;
         size_t m_width = 0;
         size_t m_height = 0;
     };
 
+    /***
+     * @brief Result of [find_spin_cycle]
+     */
+    struct SpinCycle {
+        /// number of spin cycles until the field state first repeats
+        size_t loop_start;
+
+        /// number of spin cycles between two repetitions
+        size_t loop_size;
+
+        /// number of spin cycles that were applied to the field during the detection
+        size_t steps;
+
+        /// loads[i] = `sum_field()` after `i` spin cycles (for i <= steps)
+        std::vector<size_t> loads;
+
+        /***
+         * @brief The load after `n` spin cycles (without spinning anymore)
+         * @param n
+         * @return
+         */
+        [[nodiscard]] size_t load_after(size_t n) const {
+            if (n < loads.size()) {
+                return loads[n];
+            }
+            return loads[loop_start + (n - loop_start) % loop_size];
+        }
+    };
+
+    /***
+     * @brief Finds the loop in the states of repeated spin cycles (Brent's algorithm)
+     *
+     * We only remember two copies of the field (the start and the `tortoise`) and one 64-bit hash and load per
+     * step. A full comparison of the fields is only done when the hashes match; to find where the loop starts, the
+     * fields of a matching step are spun again from the start (up to `loop_start + loop_size` more cycles).
+     *
+     * @tparam SpinField anything having `spin_cycle()`, `hash()`, `sum_field()` and `==` (e.g., [Field])
+     * @param field is spun in place; ends up `steps` cycles after its initial state
+     * @return
+     */
+    template<typename SpinField>
+    SpinCycle find_spin_cycle(SpinField &field) {
+        // hashes[i] = hash after `i` spin cycles
+        std::vector<uint64_t> hashes = {field.hash()};
+        std::vector<size_t> loads = {field.sum_field()};
+        SpinField first = field;
+        SpinField tortoise = field;
+        field.spin_cycle();
+        hashes.push_back(field.hash());
+        loads.push_back(field.sum_field());
+
+        // find the loop size: the tortoise teleports to the hare at every power of two
+        size_t power = 1;
+        size_t loop_size = 1;
+        while (tortoise.hash() != field.hash() || !(tortoise == field)) {
+            if (power == loop_size) {
+                tortoise = field;
+                power *= 2;
+                loop_size = 0;
+            }
+            field.spin_cycle();
+            hashes.push_back(field.hash());
+            loads.push_back(field.sum_field());
+            ++loop_size;
+        }
+
+        // the loop starts at the first step which repeats `loop_size` steps later
+        // (the last step is such a step, so this always terminates); hashes only rule steps out, a match is
+        // confirmed on the fields spun again from the start
+        size_t loop_start = 0;
+        size_t first_steps = 0;
+        SpinField second = first;
+        for (size_t i = 0; i < loop_size; ++i) {
+            second.spin_cycle();
+        }
+        while (true) {
+            if (hashes[loop_start] == hashes[loop_start + loop_size]) {
+                for (; first_steps < loop_start; ++first_steps) {
+                    first.spin_cycle();
+                    second.spin_cycle();
+                }
+                if (first == second) {
+                    break;
+                }
+            }
+            ++loop_start;
+        }
+
+        return {
+                .loop_start = loop_start,
+                .loop_size = loop_size,
+                .steps = hashes.size() - 1,
+                .loads = std::move(loads),
+        };
+    }
+
+    /***
+     * @brief Answers of both parts for one grid of [day14_batch]
+     */
+    struct GridAnswer {
+        int part1;
+        int part2;
+    };
+
+    /***
+     * @brief Result of [day14_batch]
+     */
+    struct BatchResult {
+        /// one per grid in the order of the input
+        std::vector<GridAnswer> answers;
+
+        /// wall time of solving (without reading the input)
+        double seconds;
+
+        [[nodiscard]] double grids_per_second() const {
+            return seconds > 0 ? static_cast<double>(answers.size()) / seconds : 0;
+        }
+    };
+
+    /***
+     * @brief Solves both parts for many grids at once
+     *
+     * The grids are separated by empty lines. The input is read into one buffer, the grids are handed
+     * out one by one to the workers of `pool` and every worker parses its fields into its own arena,
+     * which is reset (not freed) after every grid.
+     *
+     * The arena only holds the parsed cells ([Field::m_field]). Everything else a grid needs still comes from the
+     * global heap: the [SparseField] tables and stone lists, the hashes and loads of [find_spin_cycle] and the
+     * field copies it keeps.
+     *
+     * @param input
+     * @param pool
+     * @return
+     */
+    BatchResult day14_batch(std::istream &input, utils::ThreadPool &pool);
+
     int day14_1(const std::vector<std::string>& input);
-    int day14_2(const std::vector<std::string>& input);
+    /***
+     * @brief Runs the spin cycle detection once, ask the result for as many cycle counts as needed
+     * @param input
+     * @return
+     */
+    SpinCycle day14_spin_cycle(const std::vector<std::string>& input);
+
+    int day14_2(const std::vector<std::string>& input, size_t iterations = 1000000000);
 
 }
 #endif //AOC2024_DAY14_H
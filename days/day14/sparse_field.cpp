@@ -0,0 +1,138 @@
+#include "sparse_field.h"
+#include <algorithm>
+#include <limits>
+
+namespace aoc2024::day14 {
+    namespace {
+        constexpr uint32_t NO_SEGMENT = std::numeric_limits<uint32_t>::max();
+    }
+
+    SparseField SparseField::from_field(const Field &field) {
+        const size_t width = field.width();
+        const size_t height = field.height();
+        auto tables = std::make_shared<Tables>();
+        tables->width = width;
+        tables->height = height;
+
+        SparseField sparse;
+        for (size_t y = 0; y < height; ++y) {
+            for (size_t x = 0; x < width; ++x) {
+                const auto index = static_cast<uint32_t>(y * width + x);
+                switch (field.get(x, y)) {
+                    case FieldType::MOVEABLE_STONE:
+                        sparse.m_stones.push_back(index);
+                        sparse.m_hash ^= zobrist_key(index);
+                        break;
+                    case FieldType::FIXED_STONE:
+                        tables->rocks.push_back(index);
+                        break;
+                    case FieldType::FREE:
+                        break;
+                }
+            }
+        }
+
+        // cut every line (`lines` lines of `length` cells, cell `pos` of line `line` is `index(line, pos)`)
+        // into segments at the fixed stones
+        const auto build = [&](Segments &segments, size_t lines, size_t length, auto index) {
+            segments.of_cell = std::vector<uint32_t>(width * height, NO_SEGMENT);
+            for (size_t line = 0; line < lines; ++line) {
+                bool in_segment = false;
+                for (size_t pos = 0; pos < length; ++pos) {
+                    const auto [x, y] = index(line, pos);
+                    const auto cell = static_cast<uint32_t>(y * width + x);
+                    if (field.get(x, y) == FieldType::FIXED_STONE) {
+                        in_segment = false;
+                        continue;
+                    }
+                    if (!in_segment) {
+                        segments.first.push_back(cell);
+                        segments.last.push_back(cell);
+                        in_segment = true;
+                    }
+                    segments.of_cell[cell] = static_cast<uint32_t>(segments.first.size() - 1);
+                    segments.last.back() = cell;
+                }
+            }
+        };
+        build(tables->vertical, width, height, [](size_t x, size_t y) { return std::pair{x, y}; });
+        build(tables->horizontal, height, width, [](size_t y, size_t x) { return std::pair{x, y}; });
+
+        sparse.m_counts = std::vector<uint32_t>(
+                std::max(tables->vertical.first.size(), tables->horizontal.first.size()), 0);
+        sparse.m_tables = std::move(tables);
+        return sparse;
+    }
+
+    Field SparseField::to_field() const {
+        Field field(m_tables->width, m_tables->height);
+        for (const auto index: m_tables->rocks) {
+            field.set(index % m_tables->width, index / m_tables->width, FieldType::FIXED_STONE);
+        }
+        for (const auto index: m_stones) {
+            field.set(index % m_tables->width, index / m_tables->width, FieldType::MOVEABLE_STONE);
+        }
+        return field;
+    }
+
+    void SparseField::tilt(TiltDir dir) {
+        const bool vertical = dir == TiltDir::NORTH || dir == TiltDir::SOUTH;
+        const bool towards_first = dir == TiltDir::NORTH || dir == TiltDir::WEST;
+        const Segments &segments = vertical ? m_tables->vertical : m_tables->horizontal;
+        const auto &landing = towards_first ? segments.first : segments.last;
+        const auto cell_step = static_cast<int64_t>(vertical ? m_tables->width : 1);
+        const int64_t step = towards_first ? cell_step : -cell_step;
+
+        // count the stones per segment
+        m_touched.clear();
+        for (const auto index: m_stones) {
+            const auto segment = segments.of_cell[index];
+            if (m_counts[segment]++ == 0) {
+                m_touched.push_back(segment);
+            }
+        }
+
+        // and stack them up from the landing slot of their segment
+        m_stones.clear();
+        m_hash = 0;
+        for (const auto segment: m_touched) {
+            auto index = static_cast<int64_t>(landing[segment]);
+            for (uint32_t i = 0; i < m_counts[segment]; ++i, index += step) {
+                m_stones.push_back(static_cast<uint32_t>(index));
+                m_hash ^= zobrist_key(index);
+            }
+            m_counts[segment] = 0;
+        }
+    }
+
+    void SparseField::spin_cycle() {
+        tilt(TiltDir::NORTH);
+        tilt(TiltDir::WEST);
+        tilt(TiltDir::SOUTH);
+        tilt(TiltDir::EAST);
+    }
+
+    std::size_t SparseField::sum_field() const {
+        size_t score = 0;
+        for (const auto index: m_stones) {
+            score += m_tables->height - index / m_tables->width;
+        }
+        return score;
+    }
+
+    bool SparseField::operator==(const SparseField &other) const {
+        if (m_tables->width != other.m_tables->width || m_tables->height != other.m_tables->height ||
+            m_stones.size() != other.m_stones.size()) {
+            return false;
+        }
+        if (m_tables != other.m_tables && m_tables->rocks != other.m_tables->rocks) {
+            return false;
+        }
+        // the order of the stones depends on the tilts that lead here
+        auto stones = m_stones;
+        auto other_stones = other.m_stones;
+        std::sort(stones.begin(), stones.end());
+        std::sort(other_stones.begin(), other_stones.end());
+        return stones == other_stones;
+    }
+}
@@ -0,0 +1,103 @@
+#ifndef AOC2024_DAY14_SPARSE_FIELD_H
+#define AOC2024_DAY14_SPARSE_FIELD_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "day14.h"
+
+namespace aoc2024::day14 {
+
+    /***
+     * @brief A [Field] that only remembers where its moveable stones are
+     *
+     * The fixed stones never move, so we precompute for every cell in which segment (run of cells between
+     * two fixed stones) it lies, once for columns and once for rows, together with the first and last cell of
+     * every segment (the landing slots when tilting to either side).
+     * A tilt then counts the stones per segment and writes them back starting at the landing slot,
+     * so its cost scales with the number of stones instead of the size of the grid.
+     */
+    class SparseField {
+    public:
+        /***
+         * @brief Builds the sparse representation from a normal [Field]
+         * @param field
+         * @return
+         */
+        static SparseField from_field(const Field &field);
+
+        /***
+         * @brief Converts back into a normal [Field] (mainly to compare against it)
+         * @return
+         */
+        [[nodiscard]] Field to_field() const;
+
+        /***
+         * @brief Tilts the field in a direction (same semantics as [Field::tilt])
+         * @param dir
+         */
+        void tilt(TiltDir dir);
+
+        /***
+         * @brief One spin cycle (tilts NORTH, WEST, SOUTH and EAST)
+         */
+        void spin_cycle();
+
+        /***
+         * @brief Returns the sum of the field (same semantics as [Field::sum_field])
+         * @return
+         */
+        [[nodiscard]] std::size_t sum_field() const;
+
+        /***
+         * @brief Same Zobrist hash as [Field::hash] for the same stones
+         * @return
+         */
+        [[nodiscard]] uint64_t hash() const {
+            return m_hash;
+        }
+
+        [[nodiscard]] bool operator==(const SparseField &other) const;
+
+        [[nodiscard]] size_t stone_count() const {
+            return m_stones.size();
+        }
+
+    private:
+        /***
+         * @brief Segments of all columns (or all rows)
+         */
+        struct Segments {
+            /// segment of every cell (row-major index); rocks have no segment
+            std::vector<uint32_t> of_cell;
+
+            /// first and last cell (row-major index) of every segment
+            std::vector<uint32_t> first;
+            std::vector<uint32_t> last;
+        };
+
+        /***
+         * @brief Everything which does not change when tilting (shared between copies of a field)
+         */
+        struct Tables {
+            size_t width;
+            size_t height;
+            Segments vertical;
+            Segments horizontal;
+            std::vector<uint32_t> rocks;
+        };
+
+        std::shared_ptr<const Tables> m_tables;
+
+        /// row-major indices of the moveable stones (in no particular order)
+        std::vector<uint32_t> m_stones;
+
+        /// scratch space for [tilt]: stones per segment and the segments having any
+        std::vector<uint32_t> m_counts;
+        std::vector<uint32_t> m_touched;
+
+        uint64_t m_hash = 0;
+    };
+}
+
+#endif //AOC2024_DAY14_SPARSE_FIELD_H
@@ -0,0 +1,188 @@
+#include "tilt_kernel.h"
+#include "bit_line.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define AOC2024_TILT_KERNEL_AVX2 1
+#include <immintrin.h>
+#else
+#define AOC2024_TILT_KERNEL_AVX2 0
+#endif
+
+namespace aoc2024::day14 {
+    namespace {
+        constexpr auto STONE = static_cast<uint8_t>(FieldType::MOVEABLE_STONE);
+        constexpr auto ROCK = static_cast<uint8_t>(FieldType::FIXED_STONE);
+        constexpr auto FREE = static_cast<uint8_t>(FieldType::FREE);
+
+        void tilt_run_scalar(FieldType *cells, size_t n, bool towards_low, std::vector<uint64_t> &changed) {
+            changed.assign((n + bits::WORD_BITS - 1) / bits::WORD_BITS, 0);
+            // a cell may be emptied and filled again later, so we toggle
+            const auto toggle = [&](size_t i) {
+                changed[i / bits::WORD_BITS] ^= uint64_t{1} << (i % bits::WORD_BITS);
+            };
+            const auto move_stone = [&](size_t from, size_t to) {
+                cells[to] = FieldType::MOVEABLE_STONE;
+                cells[from] = FieldType::FREE;
+                toggle(from);
+                toggle(to);
+            };
+
+            if (towards_low) {
+                size_t free = 0; // where the next stone lands
+                for (size_t i = 0; i < n; ++i) {
+                    switch (cells[i]) {
+                        case FieldType::FIXED_STONE:
+                            free = i + 1;
+                            break;
+                        case FieldType::MOVEABLE_STONE:
+                            if (free != i) {
+                                move_stone(i, free);
+                            }
+                            ++free;
+                            break;
+                        case FieldType::FREE:
+                            break;
+                    }
+                }
+            } else {
+                size_t free = n; // one behind where the next stone lands
+                for (size_t i = n; i-- > 0;) {
+                    switch (cells[i]) {
+                        case FieldType::FIXED_STONE:
+                            free = i;
+                            break;
+                        case FieldType::MOVEABLE_STONE:
+                            if (free - 1 != i) {
+                                move_stone(i, free - 1);
+                            }
+                            --free;
+                            break;
+                        case FieldType::FREE:
+                            break;
+                    }
+                }
+            }
+        }
+
+#if AOC2024_TILT_KERNEL_AVX2
+        /***
+         * @brief byte `i` is 0xff if bit `i` of `mask` is set
+         */
+        __attribute__((target("avx2")))
+        inline __m256i expand_mask(uint32_t mask) {
+            // byte i gets byte i / 8 of the mask and then checks its bit i % 8
+            const __m256i spread = _mm256_shuffle_epi8(
+                    _mm256_set1_epi32(static_cast<int>(mask)),
+                    _mm256_setr_epi64x(0x0000000000000000, 0x0101010101010101,
+                                       0x0202020202020202, 0x0303030303030303));
+            const __m256i bit = _mm256_set1_epi64x(static_cast<long long>(0x8040201008040201ULL));
+            return _mm256_cmpeq_epi8(_mm256_and_si256(spread, bit), bit);
+        }
+
+        /***
+         * @brief Turns the cells into stone / rock bitsets (32 cells per compare), tilts those
+         * (see [bits::tilt_line]) and only writes back 32 byte blocks that changed
+         */
+        __attribute__((target("avx2")))
+        void tilt_run_avx2(FieldType *cells, size_t n, bool towards_low, std::vector<uint64_t> &changed) {
+            constexpr size_t lanes = 32;
+            const size_t words = (n + bits::WORD_BITS - 1) / bits::WORD_BITS;
+            thread_local std::vector<uint64_t> stones;
+            thread_local std::vector<uint64_t> rocks;
+            stones.assign(words, 0);
+            rocks.assign(words, 0);
+
+            auto *bytes = reinterpret_cast<uint8_t *>(cells);
+            const __m256i stone_v = _mm256_set1_epi8(static_cast<char>(STONE));
+            const __m256i rock_v = _mm256_set1_epi8(static_cast<char>(ROCK));
+            const __m256i free_v = _mm256_set1_epi8(static_cast<char>(FREE));
+
+            size_t i = 0;
+            for (; i + lanes <= n; i += lanes) {
+                const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(bytes + i));
+                const auto stone_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, stone_v)));
+                const auto rock_bits = static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, rock_v)));
+                stones[i / bits::WORD_BITS] |= static_cast<uint64_t>(stone_bits) << (i % bits::WORD_BITS);
+                rocks[i / bits::WORD_BITS] |= static_cast<uint64_t>(rock_bits) << (i % bits::WORD_BITS);
+            }
+            for (; i < n; ++i) {
+                const uint64_t bit = uint64_t{1} << (i % bits::WORD_BITS);
+                if (bytes[i] == STONE) {
+                    stones[i / bits::WORD_BITS] |= bit;
+                } else if (bytes[i] == ROCK) {
+                    rocks[i / bits::WORD_BITS] |= bit;
+                }
+            }
+
+            changed.assign(stones.begin(), stones.end());
+            bits::tilt_line(stones.data(), rocks.data(), n, towards_low);
+            for (size_t w = 0; w < words; ++w) {
+                changed[w] ^= stones[w];
+            }
+
+            // changed cells are never rocks, they are either a stone or free now
+            for (i = 0; i + lanes <= n; i += lanes) {
+                const auto diff = static_cast<uint32_t>(changed[i / bits::WORD_BITS] >> (i % bits::WORD_BITS));
+                if (diff == 0) {
+                    continue;
+                }
+                const auto stone_bits = static_cast<uint32_t>(stones[i / bits::WORD_BITS] >> (i % bits::WORD_BITS));
+                auto *block = reinterpret_cast<__m256i *>(bytes + i);
+                const __m256i updated = _mm256_blendv_epi8(free_v, stone_v, expand_mask(stone_bits));
+                _mm256_storeu_si256(block, _mm256_blendv_epi8(_mm256_loadu_si256(block), updated,
+                                                              expand_mask(diff)));
+            }
+            for (; i < n; ++i) {
+                if ((changed[i / bits::WORD_BITS] >> (i % bits::WORD_BITS)) & 1) {
+                    const bool stone = (stones[i / bits::WORD_BITS] >> (i % bits::WORD_BITS)) & 1;
+                    bytes[i] = stone ? STONE : FREE;
+                }
+            }
+        }
+#endif
+
+        TiltKernel best_kernel() {
+            return tilt_kernel_supported(TiltKernel::AVX2) ? TiltKernel::AVX2 : TiltKernel::SCALAR;
+        }
+
+        TiltKernel active_kernel = best_kernel();
+    }
+
+    bool tilt_kernel_supported(TiltKernel kernel) {
+        switch (kernel) {
+            case TiltKernel::SCALAR:
+                return true;
+            case TiltKernel::AVX2:
+#if AOC2024_TILT_KERNEL_AVX2
+                // might run during static initialization, before the runtime did this on its own
+                __builtin_cpu_init();
+                return __builtin_cpu_supports("avx2");
+#else
+                return false;
+#endif
+        }
+        return false;
+    }
+
+    bool set_tilt_kernel(TiltKernel kernel) {
+        if (!tilt_kernel_supported(kernel)) {
+            return false;
+        }
+        active_kernel = kernel;
+        return true;
+    }
+
+    TiltKernel tilt_kernel() {
+        return active_kernel;
+    }
+
+    void tilt_run(FieldType *cells, size_t n, bool towards_low, std::vector<uint64_t> &changed) {
+#if AOC2024_TILT_KERNEL_AVX2
+        if (active_kernel == TiltKernel::AVX2) {
+            tilt_run_avx2(cells, n, towards_low, changed);
+            return;
+        }
+#endif
+        tilt_run_scalar(cells, n, towards_low, changed);
+    }
+}
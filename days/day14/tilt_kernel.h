@@ -0,0 +1,51 @@
+#ifndef AOC2024_DAY14_TILT_KERNEL_H
+#define AOC2024_DAY14_TILT_KERNEL_H
+
+#include <cstdint>
+#include <vector>
+#include "day14.h"
+
+namespace aoc2024::day14 {
+
+    /***
+     * @brief Implementations of [tilt_run]
+     */
+    enum class TiltKernel {
+        /// one cell after the other (works everywhere)
+        SCALAR,
+
+        /// 32 cells at once with AVX2 byte compares (x86-64 CPUs having AVX2 only)
+        AVX2,
+    };
+
+    /***
+     * @brief Moves the stones of `n` contiguous cells to the low (`towards_low`) or high end of every
+     * run between two fixed stones
+     *
+     * Uses the kernel picked by [set_tilt_kernel] (by default the fastest one the CPU supports).
+     *
+     * @param cells
+     * @param n
+     * @param towards_low
+     * @param changed receives one bit per cell (`ceil(n / 64)` words) which is set if the cell changed
+     */
+    void tilt_run(FieldType *cells, size_t n, bool towards_low, std::vector<uint64_t> &changed);
+
+    /***
+     * @brief Whether the CPU we run on can use `kernel`
+     * @param kernel
+     * @return
+     */
+    [[nodiscard]] bool tilt_kernel_supported(TiltKernel kernel);
+
+    /***
+     * @brief Picks the kernel used by [tilt_run] (ignored if the CPU does not support it)
+     * @param kernel
+     * @return whether the kernel is used now
+     */
+    bool set_tilt_kernel(TiltKernel kernel);
+
+    [[nodiscard]] TiltKernel tilt_kernel();
+}
+
+#endif //AOC2024_DAY14_TILT_KERNEL_H
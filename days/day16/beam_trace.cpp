@@ -0,0 +1,220 @@
+#include "beam_trace.h"
+#include <cstddef>
+#include <iostream>
+
+namespace aoc2024::day16 {
+    namespace {
+        constexpr char MAGIC[4] = {'B', '1', '6', 'T'};
+        constexpr uint32_t VERSION = 1;
+
+        /// a trace file starts with this, followed by one byte ([FieldType]) per cell and the records
+        struct TraceHeader {
+            char magic[4];
+            uint32_t version;
+            uint32_t width;
+            uint32_t height;
+            uint64_t records;
+        };
+
+        /// records start at the first multiple of their size after the cells
+        size_t records_offset(size_t width, size_t height) {
+            const size_t end = sizeof(TraceHeader) + width * height;
+            return (end + sizeof(TraceRecord) - 1) / sizeof(TraceRecord) * sizeof(TraceRecord);
+        }
+
+        /// cells in a row of `to - from` (going `dir` from `from`)
+        size_t distance(size_t from, size_t to, Direction dir, size_t width) {
+            const size_t cells = from > to ? from - to : to - from;
+            return dir == Direction::UP || dir == Direction::DOWN ? cells / width : cells;
+        }
+
+        ptrdiff_t delta(Direction dir, size_t width) {
+            switch (dir) {
+                case Direction::UP:
+                    return -static_cast<ptrdiff_t>(width);
+                case Direction::DOWN:
+                    return static_cast<ptrdiff_t>(width);
+                case Direction::LEFT:
+                    return -1;
+                case Direction::RIGHT:
+                    return 1;
+            }
+            return 0;
+        }
+    }
+
+    BeamTraceWriter::BeamTraceWriter(const std::string &path, const Field &field) {
+        const size_t offset = records_offset(field.width(), field.height());
+        m_file = utils::MappedFile::create(path, offset + 65536 * sizeof(TraceRecord));
+        if (!m_file.has_value()) {
+            return;
+        }
+        m_data = m_file->mutable_data();
+        m_capacity = m_file->size();
+
+        TraceHeader header{};
+        std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+        header.version = VERSION;
+        header.width = static_cast<uint32_t>(field.width());
+        header.height = static_cast<uint32_t>(field.height());
+        std::memcpy(m_data, &header, sizeof(header));
+        for (size_t y = 0; y < field.height(); ++y) {
+            for (size_t x = 0; x < field.width(); ++x) {
+                m_data[sizeof(header) + y * field.width() + x] = static_cast<uint8_t>(field.get(x, y).value());
+            }
+        }
+        m_used = offset;
+    }
+
+    BeamTraceWriter::~BeamTraceWriter() {
+        finish();
+    }
+
+    bool BeamTraceWriter::grow() {
+        if (!m_file.has_value()) {
+            return false;
+        }
+        if (!m_file->resize(m_capacity * 2)) {
+            // the old mapping is gone already, the trace is lost (its header still says 0 records)
+            std::cerr << "Could not grow the beam trace to " << m_capacity * 2 << " bytes" << std::endl;
+            m_file.reset();
+            m_data = nullptr;
+            m_capacity = 0;
+            return false;
+        }
+        m_data = m_file->mutable_data();
+        m_capacity = m_file->size();
+        return true;
+    }
+
+    void BeamTraceWriter::finish() {
+        if (!m_file.has_value() || m_data == nullptr) {
+            return;
+        }
+        const uint64_t records = m_records;
+        std::memcpy(m_data + offsetof(TraceHeader, records), &records, sizeof(records));
+        m_file->resize(m_used);
+        m_file.reset();
+        m_data = nullptr;
+        m_capacity = 0;
+    }
+
+    BeamTraceReader::BeamTraceReader(utils::MappedFile file) : m_file(std::move(file)) {
+        TraceHeader header{};
+        std::memcpy(&header, m_file.data(), sizeof(header));
+        m_width = header.width;
+        m_height = header.height;
+        m_records = header.records;
+        m_records_offset = records_offset(m_width, m_height);
+    }
+
+    std::optional<BeamTraceReader> BeamTraceReader::open(const std::string &path) {
+        auto file = utils::MappedFile::open(path);
+        if (!file.has_value()) {
+            return std::nullopt;
+        }
+        TraceHeader header{};
+        if (file->size() < sizeof(header)) {
+            std::cerr << path << " is no beam trace" << std::endl;
+            return std::nullopt;
+        }
+        std::memcpy(&header, file->data(), sizeof(header));
+        if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 || header.version != VERSION ||
+            file->size() < records_offset(header.width, header.height) + header.records * sizeof(TraceRecord)) {
+            std::cerr << path << " is no beam trace (or was not finished)" << std::endl;
+            return std::nullopt;
+        }
+        return BeamTraceReader(std::move(file.value()));
+    }
+
+    std::span<const TraceRecord> BeamTraceReader::records() const {
+        return {reinterpret_cast<const TraceRecord *>(m_file.data() + m_records_offset), m_records};
+    }
+
+    uint32_t BeamTraceReader::frames() const {
+        const auto all = records();
+        return all.empty() ? 0 : all.back().frame;
+    }
+
+    Field BeamTraceReader::field() const {
+        Field field;
+        field.init_field(m_width, m_height);
+        const uint8_t *cells = m_file.data() + sizeof(TraceHeader);
+        for (size_t y = 0; y < m_height; ++y) {
+            for (size_t x = 0; x < m_width; ++x) {
+                field.set(x, y, static_cast<FieldType>(cells[y * m_width + x]));
+            }
+        }
+        return field;
+    }
+
+    BeamState BeamTraceReader::frame(uint32_t frame) const {
+        BeamState state;
+        state.reset(m_width * m_height);
+        state.frame = frame;
+
+        // where every beam was at its last event
+        struct Track {
+            size_t cell;
+            Direction dir;
+            uint32_t frame;
+            bool alive;
+        };
+        std::vector<Track> tracks;
+
+        // marks `count` cells starting at `cell` going `dir` as visited
+        const auto visit = [&](size_t cell, Direction dir, size_t count) {
+            for (size_t i = 0; i < count; ++i, cell += delta(dir, m_width)) {
+                state.visit(cell, dir);
+            }
+        };
+
+        for (const auto &record: records()) {
+            if (record.frame > frame) {
+                break;
+            }
+            const auto dir = static_cast<Direction>(record.dir);
+            if (record.beam >= tracks.size()) {
+                tracks.resize(record.beam + 1, Track{0, Direction::UP, 0, false});
+            }
+            Track &track = tracks[record.beam];
+            switch (record.event) {
+                case TraceEvent::SPAWN:
+                    track = Track{record.cell, dir, record.frame, true};
+                    break;
+                case TraceEvent::REFLECT:
+                    // the mirror itself is visited going the new direction
+                    visit(track.cell, track.dir, distance(track.cell, record.cell, track.dir, m_width));
+                    track = Track{record.cell, dir, record.frame, true};
+                    break;
+                case TraceEvent::SPLIT:
+                    // the splitter is visited by the spawned beams
+                    visit(track.cell, track.dir, distance(track.cell, record.cell, track.dir, m_width));
+                    track.alive = false;
+                    break;
+                case TraceEvent::ABSORB:
+                    visit(track.cell, track.dir, distance(track.cell, record.cell, track.dir, m_width) + 1);
+                    track.alive = false;
+                    break;
+            }
+            state.next_beam_id = std::max<uint32_t>(state.next_beam_id, record.beam + 1);
+        }
+
+        for (uint32_t id = 0; id < tracks.size(); ++id) {
+            const Track &track = tracks[id];
+            if (!track.alive) {
+                continue;
+            }
+            // beams do not move in frame 1 and are only marked as visited once they moved
+            const uint32_t first_moving = std::max<uint32_t>(track.frame, 1);
+            const size_t moves = frame > first_moving ? frame - first_moving : 0;
+            const size_t cell = track.cell + moves * delta(track.dir, m_width);
+            if (frame > 0) {
+                visit(track.cell, track.dir, moves + 1);
+            }
+            state.beams.push_back(Beam{.x = cell % m_width, .y = cell / m_width, .dir = track.dir, .id = id});
+        }
+        state.first_move = frame == 0;
+        return state;
+    }
+}
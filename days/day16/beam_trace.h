@@ -0,0 +1,152 @@
+#ifndef AOC2024_DAY16_BEAM_TRACE_H
+#define AOC2024_DAY16_BEAM_TRACE_H
+
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <span>
+#include <string>
+#include "day16.h"
+#include "../../utils/mapped_file.h"
+
+namespace aoc2024::day16 {
+
+    enum class TraceEvent : uint8_t {
+        /// a beam appears (added to the field or created by a splitter)
+        SPAWN,
+
+        /// a beam hits a splitter from the side and ends (the two new beams are spawned at the same cell)
+        SPLIT,
+
+        /// a beam hits a mirror and goes on in [TraceRecord::dir]
+        REFLECT,
+
+        /// a beam ends: it left the field (the record has its last cell) or follows a path taken before
+        ABSORB,
+    };
+
+    /***
+     * @brief One event of a [Field::move_beams] run, as stored in a trace file
+     *
+     * Between two events a beam moves one cell per frame in its direction (except in frame 1, where
+     * [Field::move_beams] only looks at the cell the beams start on).
+     */
+    struct TraceRecord {
+        /// number of [Field::move_beams] calls done when the event happened (0 for beams added at the start)
+        uint32_t frame;
+        uint32_t beam;
+        uint32_t cell;
+        TraceEvent event;
+
+        /// direction of the beam after the event, as in [Direction]
+        uint8_t dir;
+        uint16_t reserved;
+    };
+    static_assert(sizeof(TraceRecord) == 16);
+
+    /***
+     * @brief Appends [TraceRecord]s to a memory mapped trace file
+     *
+     * The file starts with a header (see beam_trace.cpp) and the cells of the field, so a trace can be
+     * rendered on its own. Hand the writer to [Field::trace] to record every following [Field::move_beams].
+     */
+    class BeamTraceWriter {
+    public:
+        BeamTraceWriter(const std::string &path, const Field &field);
+
+        ~BeamTraceWriter();
+
+        BeamTraceWriter(const BeamTraceWriter &) = delete;
+
+        BeamTraceWriter &operator=(const BeamTraceWriter &) = delete;
+
+        /***
+         * @brief whether the file could be created and grown so far (if not, records are dropped)
+         */
+        [[nodiscard]] bool ok() const {
+            return m_file.has_value();
+        }
+
+        void record(TraceEvent event, uint32_t frame, uint32_t beam, size_t cell, Direction dir) {
+            if (m_used + sizeof(TraceRecord) > m_capacity && !grow()) {
+                return;
+            }
+            const TraceRecord record{.frame = frame, .beam = beam, .cell = static_cast<uint32_t>(cell),
+                                     .event = event, .dir = static_cast<uint8_t>(dir), .reserved = 0};
+            std::memcpy(m_data + m_used, &record, sizeof(record));
+            m_used += sizeof(record);
+            ++m_records;
+        }
+
+        [[nodiscard]] size_t records() const {
+            return m_records;
+        }
+
+        /***
+         * @brief Writes the number of records and cuts the file to what is used (done by the destructor as well)
+         */
+        void finish();
+
+    private:
+        bool grow();
+
+        std::optional<utils::MappedFile> m_file;
+        uint8_t *m_data = nullptr;
+        size_t m_used = 0;
+        size_t m_capacity = 0;
+        size_t m_records = 0;
+    };
+
+    /***
+     * @brief Reads a trace file written by [BeamTraceWriter] and rebuilds frames from it (no simulation involved)
+     */
+    class BeamTraceReader {
+    public:
+        /***
+         * @param path
+         * @return nullopt (and a message on stderr) if the file is no trace
+         */
+        static std::optional<BeamTraceReader> open(const std::string &path);
+
+        [[nodiscard]] size_t width() const {
+            return m_width;
+        }
+
+        [[nodiscard]] size_t height() const {
+            return m_height;
+        }
+
+        [[nodiscard]] std::span<const TraceRecord> records() const;
+
+        /***
+         * @brief the last frame the trace has events for
+         */
+        [[nodiscard]] uint32_t frames() const;
+
+        /***
+         * @brief the traced field (without any beams)
+         */
+        [[nodiscard]] Field field() const;
+
+        /***
+         * @brief The beams and visited states after `frame` [Field::move_beams] calls
+         *
+         * Render it with [Field::to_string], [Field::energy_map] or [Field::to_visited_map_string] of [field].
+         *
+         * @param frame
+         * @return
+         */
+        [[nodiscard]] BeamState frame(uint32_t frame) const;
+
+    private:
+        explicit BeamTraceReader(utils::MappedFile file);
+
+        utils::MappedFile m_file;
+        size_t m_width = 0;
+        size_t m_height = 0;
+        size_t m_records = 0;
+        size_t m_records_offset = 0;
+    };
+}
+
+#endif //AOC2024_DAY16_BEAM_TRACE_H
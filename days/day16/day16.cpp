@@ -3,51 +3,59 @@
 //
 
 #include "day16.h"
+#include "beam_trace.h"
+#include "splitter_graph.h"
+#include "../../utils/bit_line.h"
 #include <iostream>
 
 namespace aoc2024::day16 {
-    std::string Field::energy_map() const {
+    namespace bits = utils::bits;
+
+    std::string Field::energy_map(const BeamState &state) const {
         std::string result;
         for (size_t y = 0; y < height(); ++y) {
             for (size_t x = 0; x < width(); ++x) {
-                result += is_energized(x, y) ? '#' : '.';
+                result += is_energized(state, x, y) ? '#' : '.';
             }
             result += '\n';
         }
         return result;
     }
 
-    std::string Field::to_string() const {
+    std::string Field::to_string(const BeamState &state) const {
+        // bucket the beams by cell first, so we do not look at every beam for every cell
+        std::vector<uint32_t> beam_count(width() * height(), 0);
+        std::vector<Direction> beam_dir(width() * height(), Direction::UP);
+        for (const auto &beam: state.beams) {
+            const size_t cell = beam.y * width() + beam.x;
+            if (beam_count[cell]++ == 0) {
+                beam_dir[cell] = beam.dir;
+            }
+        }
+
         std::string result;
         for (size_t y = 0; y < height(); ++y) {
             for (size_t x = 0; x < width(); ++x) {
-                size_t found_beam = 0;
-                for (const auto &beam: m_beams) {
-                    if (beam.x == x && beam.y == y) {
-                        found_beam += 1;
-                        if (found_beam > 1) {
-                            result[result.size() - 1] = std::to_string(found_beam).at(0);
-                        } else {
-                            switch (beam.dir) {
-                                case Direction::UP:
-                                    result += '^';
-                                    break;
-                                case Direction::DOWN:
-                                    result += 'v';
-                                    break;
-                                case Direction::LEFT:
-                                    result += '<';
-                                    break;
-                                case Direction::RIGHT:
-                                    result += '>';
-                                    break;
-                            }
-                        }
+                const size_t cell = y * width() + x;
+                if (beam_count[cell] > 1) {
+                    // more than one beam: print the number (its first digit)
+                    result += std::to_string(beam_count[cell]).at(0);
+                } else if (beam_count[cell] == 1) {
+                    switch (beam_dir[cell]) {
+                        case Direction::UP:
+                            result += '^';
+                            break;
+                        case Direction::DOWN:
+                            result += 'v';
+                            break;
+                        case Direction::LEFT:
+                            result += '<';
+                            break;
+                        case Direction::RIGHT:
+                            result += '>';
+                            break;
                     }
-                }
-
-                if (found_beam == 0) {
-
+                } else {
                     switch (get(x, y).value()) {
                         case FieldType::SPACE:
                             result += '.';
@@ -72,11 +80,11 @@ namespace aoc2024::day16 {
         return result;
     }
 
-    std::string Field::to_visited_map_string() const {
+    std::string Field::to_visited_map_string(const BeamState &state) const {
         std::string result;
         for (size_t y = 0; y < height(); ++y) {
             for (size_t x = 0; x < width(); ++x) {
-                uint8_t dir_num = get_visit_state(x, y);
+                uint8_t dir_num = state.visit_state(y * width() + x);
                 if (dir_num == 0) {
                     result += '.';
                 } else {
@@ -89,6 +97,15 @@ namespace aoc2024::day16 {
     }
 
     Field Field::parse(const std::vector<std::string> &input) {
+        return parse_lines(input);
+    }
+
+    Field Field::parse(std::span<const std::string_view> input) {
+        return parse_lines(input);
+    }
+
+    template<typename Lines>
+    Field Field::parse_lines(const Lines &input) {
         Field field;
         if (input.empty()) {
             std::cerr << "Input is empty" << std::endl;
@@ -97,6 +114,8 @@ namespace aoc2024::day16 {
         size_t width = input[0].size();
         size_t height = input.size();
         field.init_field(width, height);
+        // no need to keep the jump tables up to date for every cell, we build them at the end
+        field.m_jumps_valid = false;
         for (size_t y = 0; y < height; ++y) {
             for (size_t x = 0; x < width; ++x) {
                 switch (input[y][x]) {
@@ -116,28 +135,50 @@ namespace aoc2024::day16 {
                         field.set(x, y, FieldType::SPLITTER_VERTICAL);
                         break;
                     default:
+                        // the cells read so far stay, the tables have to match them
                         std::cerr << "Unknown character " << input[y][x] << std::endl;
+                        field.build_jump_tables();
                         return field;
                 }
             }
         }
+        field.build_jump_tables();
 
         return field;
     }
 
-    void Field::move_beams() {
+    void Field::add_beam(BeamState &state, Beam beam) const {
+        if (beam.x >= width() || beam.y >= height()) {
+            return;
+        }
+        beam.id = state.next_beam_id++;
+        if (state.trace != nullptr) {
+            state.trace->record(TraceEvent::SPAWN, state.frame, beam.id, beam.y * width() + beam.x, beam.dir);
+        }
+        state.beams.push_back(beam);
+    }
+
+    void Field::move_beams(BeamState &state) const {
         // remember beams to add on splitters
         std::vector<Beam> new_beams;
+        ++state.frame;
+        const auto trace = [&](TraceEvent event, const Beam &beam) {
+            if (state.trace != nullptr) {
+                state.trace->record(event, state.frame, beam.id, beam.y * width() + beam.x, beam.dir);
+            }
+        };
 
         // move all beams
-        for (auto it = m_beams.begin(); it != m_beams.end();) {
+        for (auto it = state.beams.begin(); it != state.beams.end();) {
             auto &beam = *it;
             // calculate new position
             auto new_x = beam.x + ((beam.dir == Direction::RIGHT) ? 1 : beam.dir == Direction::LEFT ? -1 : 0);
             auto new_y = beam.y + ((beam.dir == Direction::DOWN) ? 1 : beam.dir == Direction::UP ? -1 : 0);
 
+            const Beam before = beam;
+
             // If the very first guy is already a bouncy thing we will need to "activate" it -> we `step back`
-            if (!first_move) {
+            if (!state.first_move) {
                 beam.x = new_x;
                 beam.y = new_y;
             } else {
@@ -149,7 +190,8 @@ namespace aoc2024::day16 {
             const auto new_field = get(new_x, new_y);
             // nothin?
             if (new_field == std::nullopt) { // out of bounds
-                it = m_beams.erase(it); // remove the beam
+                trace(TraceEvent::ABSORB, before);
+                it = state.beams.erase(it); // remove the beam
                 continue;
             }
 
@@ -171,6 +213,7 @@ namespace aoc2024::day16 {
                             beam.dir = Direction::UP;
                             break;
                     }
+                    trace(TraceEvent::REFLECT, beam);
                     break;
                 case FieldType::REFLECTOR_DOWNWARDS: // `\` (REFLECTOR_DOWNWARDS)
                     switch (beam.dir) {
@@ -187,6 +230,7 @@ namespace aoc2024::day16 {
                             beam.dir = Direction::DOWN;
                             break;
                     }
+                    trace(TraceEvent::REFLECT, beam);
                     break;
                 case FieldType::SPLITTER_HORIZONTAL: // `-` (SPLITTER_HORIZONTAL)
                     switch (beam.dir) {
@@ -196,7 +240,8 @@ namespace aoc2024::day16 {
                             // new_beams.emplace_back(new_x + 1, new_y, Direction::RIGHT);
                             new_beams.emplace_back(Beam{.x=new_x, .y=new_y, .dir=Direction::LEFT});
                             new_beams.emplace_back(Beam{.x=new_x, .y=new_y, .dir=Direction::RIGHT});
-                            it = m_beams.erase(it);
+                            trace(TraceEvent::SPLIT, beam);
+                            it = state.beams.erase(it);
                             continue; // step out (we deleted the current beam and remember the new ones)
                         case Direction::LEFT:       // those do nothing
                         case Direction::RIGHT:
@@ -210,7 +255,8 @@ namespace aoc2024::day16 {
                         case Direction::RIGHT:
                             new_beams.emplace_back(Beam{.x=new_x, .y=new_y, .dir=Direction::UP});
                             new_beams.emplace_back(Beam{.x=new_x, .y=new_y, .dir=Direction::DOWN});
-                            it = m_beams.erase(it);
+                            trace(TraceEvent::SPLIT, beam);
+                            it = state.beams.erase(it);
                             continue;
                         case Direction::UP:       // those do nothing
                         case Direction::DOWN:
@@ -224,59 +270,197 @@ namespace aoc2024::day16 {
 
         // add the new beams
         for (const auto &beam: new_beams) {
-            add_beam(beam);
+            add_beam(state, beam);
         }
 
         // remove all states we saw already
         // i.e., we do not follow paths we already visited
-        for (auto it = m_beams.begin(); it != m_beams.end();) {
+        for (auto it = state.beams.begin(); it != state.beams.end();) {
             const Beam& beam = *it;
-            if (get_visit_state(beam.x, beam.y) & static_cast<uint8_t>(beam.dir)) {
+            const size_t cell = beam.y * width() + beam.x;
+            if (state.is_visited(cell, beam.dir)) {
                 // visited already
-                it = m_beams.erase(it);
+                trace(TraceEvent::ABSORB, beam);
+                it = state.beams.erase(it);
                 continue;
             } else {
                 // remember visit
-                add_visited_state(beam.x, beam.y, beam.dir);
+                state.visit(cell, beam.dir);
                 it++;
             }
         }
 
         // remember to progress after the first move
-        first_move = false;
+        state.first_move = false;
+    }
+
+    void Field::scan_jump_line(Direction dir, size_t line) {
+        const size_t w = width();
+        const size_t h = height();
+        auto &jumps = m_jumps[direction_index(dir)];
+
+        // walk the row / column against the direction and remember the last non-space cell we saw
+        const auto scan = [&](size_t length, auto index) {
+            uint32_t next = NO_CELL;
+            for (size_t pos = 0; pos < length; ++pos) {
+                const size_t cell = index(pos);
+                jumps[cell] = next;
+                if (m_field[cell] != FieldType::SPACE) {
+                    next = static_cast<uint32_t>(cell);
+                }
+            }
+        };
+        switch (dir) {
+            case Direction::RIGHT:
+                scan(w, [&](size_t pos) { return line * w + (w - 1 - pos); });
+                break;
+            case Direction::LEFT:
+                scan(w, [&](size_t pos) { return line * w + pos; });
+                break;
+            case Direction::DOWN:
+                scan(h, [&](size_t pos) { return (h - 1 - pos) * w + line; });
+                break;
+            case Direction::UP:
+                scan(h, [&](size_t pos) { return pos * w + line; });
+                break;
+        }
+    }
+
+    void Field::build_jump_tables() {
+        for (auto &jumps: m_jumps) {
+            jumps.assign(width() * height(), NO_CELL);
+        }
+        for (size_t y = 0; y < height(); ++y) {
+            scan_jump_line(Direction::LEFT, y);
+            scan_jump_line(Direction::RIGHT, y);
+        }
+        for (size_t x = 0; x < width(); ++x) {
+            scan_jump_line(Direction::UP, x);
+            scan_jump_line(Direction::DOWN, x);
+        }
+        m_jumps_valid = true;
+    }
+
+    void Field::update_jump_tables(size_t x, size_t y) {
+        scan_jump_line(Direction::LEFT, y);
+        scan_jump_line(Direction::RIGHT, y);
+        scan_jump_line(Direction::UP, x);
+        scan_jump_line(Direction::DOWN, x);
+    }
+
+    void Field::propagate(BeamState &state, Beam start) const {
+        if (start.x >= width() || start.y >= height()) {
+            return;
+        }
+
+        const size_t w = width();
+        const size_t h = height();
+
+        // beams which are about to enter cell (x, y) going `dir`
+        auto &pending = state.pending;
+        pending.assign(1, start);
+
+        // the beam leaves cell (x, y) going `dir`: mark everything until the next mirror / splitter
+        const auto leave = [&](size_t x, size_t y, Direction dir) {
+            const size_t cell = y * w + x;
+            const uint32_t next = m_jumps[direction_index(dir)][cell];
+            auto *plane = state.visited[direction_index(dir)].data();
+
+            // a row is contiguous in the bitsets: find where an earlier beam went this way and mark everything
+            // before that with whole words at once
+            if (dir == Direction::RIGHT) {
+                const size_t end = next == NO_CELL ? (y + 1) * w : next;
+                const size_t seen = bits::next_set_bit(plane, cell, end);
+                bits::set_bits(plane, cell, seen);
+                if (seen == end && next != NO_CELL) {
+                    pending.push_back(Beam{.x = next % w, .y = y, .dir = dir});
+                }
+                return;
+            }
+            if (dir == Direction::LEFT) {
+                const size_t begin = next == NO_CELL ? y * w : next + 1;
+                const size_t seen = bits::prev_set_bit(plane, begin, cell + 1);
+                bits::set_bits(plane, seen == cell + 1 ? begin : seen + 1, cell + 1);
+                if (seen == cell + 1 && next != NO_CELL) {
+                    pending.push_back(Beam{.x = next % w, .y = y, .dir = dir});
+                }
+                return;
+            }
+
+            // a column has one bit per word, so we go cell by cell
+            const ptrdiff_t delta = dir == Direction::UP ? -static_cast<ptrdiff_t>(w) : static_cast<ptrdiff_t>(w);
+            const size_t to_border = dir == Direction::UP ? y : h - 1 - y;
+            const size_t spaces = next == NO_CELL ? to_border : (next > cell ? next - cell : cell - next) / w - 1;
+            size_t current = cell;
+            for (size_t i = 0; i <= spaces; ++i, current += delta) {
+                const uint64_t bit = uint64_t{1} << (current % 64);
+                if (plane[current / 64] & bit) {
+                    return; // someone went this way before us, so the rest is done already
+                }
+                plane[current / 64] |= bit;
+            }
+            if (next != NO_CELL) {
+                pending.push_back(Beam{.x = x, .y = next / w, .dir = dir});
+            }
+        };
+
+        while (!pending.empty()) {
+            const Beam beam = pending.back();
+            pending.pop_back();
+            const auto [first, second] = outgoing(m_field[beam.y * w + beam.x], beam.dir);
+            leave(beam.x, beam.y, first);
+            if (second.has_value()) {
+                leave(beam.x, beam.y, second.value());
+            }
+        }
     }
 
-    std::size_t Field::energy_level() const {
-        return std::count_if(m_visited_states.begin(), m_visited_states.end(), [](bool b) { return b > 0; });
+    std::size_t Field::energy_level(const BeamState &state) const {
+        size_t energy = 0;
+        for (size_t i = 0; i < state.words(); ++i) {
+            energy += std::popcount(state.energized(i));
+        }
+        return energy;
+    }
+
+    std::vector<size_t> Field::energy_levels(const std::vector<Beam> &starts, utils::ThreadPool &pool) const {
+        std::vector<size_t> levels(starts.size(), 0);
+        std::vector<BeamState> states(pool.size());
+        // every start costs at least a reset of the whole state, so small chunks balance well enough
+        pool.parallel_for(starts.size(), 4, [&](size_t begin, size_t end, size_t worker) {
+            BeamState &state = states[worker];
+            for (size_t i = begin; i < end; ++i) {
+                state.reset(width() * height());
+                propagate(state, starts[i]);
+                levels[i] = energy_level(state);
+            }
+        });
+        return levels;
     }
 
     int day16_1(const std::vector<std::string> &input) {
         Field field = Field::parse(input);
-        field.add_beam(Beam{.x=0, .y=0, .dir = Direction::RIGHT});
-        while (field.has_beams()) {
-            field.move_beams();
-        }
+        field.propagate(Beam{.x=0, .y=0, .dir = Direction::RIGHT});
         // std::cout << field.to_string() << std::endl;
         // std::cout << field.energy_map() << std::endl;
         return static_cast<int>(field.energy_level());
     }
 
-    int day16_2(const std::vector<std::string> &input) {
-        Field field = Field::parse(input);
+    std::vector<Beam> edge_beams(size_t width, size_t height) {
         std::vector<Beam> start_beams = {};
 
         // we add beams for all outer positions
 
         // left and right
-        for (size_t y = 1; y < field.height() -1; ++y) {
+        for (size_t y = 1; y < height -1; ++y) {
             start_beams.emplace_back(Beam{.x=0, .y=y, .dir = Direction::RIGHT});
-            start_beams.emplace_back(Beam{.x=field.width() - 1, .y=y, .dir = Direction::LEFT});
+            start_beams.emplace_back(Beam{.x=width - 1, .y=y, .dir = Direction::LEFT});
         }
 
         // top and bottom
-        for (size_t x = 1; x < field.width() -1; ++x) {
+        for (size_t x = 1; x < width -1; ++x) {
             start_beams.emplace_back(Beam{.x=x, .y=0, .dir = Direction::DOWN});
-            start_beams.emplace_back(Beam{.x=x, .y=field.height() - 1, .dir = Direction::UP});
+            start_beams.emplace_back(Beam{.x=x, .y=height - 1, .dir = Direction::UP});
         }
 
         // add for corners
@@ -285,27 +469,36 @@ namespace aoc2024::day16 {
         start_beams.emplace_back(Beam{.x=0, .y=0, .dir = Direction::DOWN});
 
         // 0, height - 1
-        start_beams.emplace_back(Beam{.x=0, .y=field.height() - 1, .dir = Direction::RIGHT});
-        start_beams.emplace_back(Beam{.x=0, .y=field.height() - 1, .dir = Direction::UP});
+        start_beams.emplace_back(Beam{.x=0, .y=height - 1, .dir = Direction::RIGHT});
+        start_beams.emplace_back(Beam{.x=0, .y=height - 1, .dir = Direction::UP});
 
         // width - 1, 0
-        start_beams.emplace_back(Beam{.x=field.width() - 1, .y=0, .dir = Direction::LEFT});
-        start_beams.emplace_back(Beam{.x=field.width() - 1, .y=0, .dir = Direction::DOWN});
+        start_beams.emplace_back(Beam{.x=width - 1, .y=0, .dir = Direction::LEFT});
+        start_beams.emplace_back(Beam{.x=width - 1, .y=0, .dir = Direction::DOWN});
 
         // width - 1, height - 1
-        start_beams.emplace_back(Beam{.x=field.width() - 1, .y=field.height() - 1, .dir = Direction::LEFT});
-        start_beams.emplace_back(Beam{.x=field.width() - 1, .y=field.height() - 1, .dir = Direction::UP});
+        start_beams.emplace_back(Beam{.x=width - 1, .y=height - 1, .dir = Direction::LEFT});
+        start_beams.emplace_back(Beam{.x=width - 1, .y=height - 1, .dir = Direction::UP});
 
+        return start_beams;
+    }
+
+    int day16_2(const std::vector<std::string> &input) {
+        const Field field = Field::parse(input);
+
+        // every start only follows its beam until the first splitter, the rest is looked up
+        const SplitterGraph graph(field);
         std::size_t max_score = 0;
-        for (const auto& beam: start_beams) {
-            field.reset();
-            field.add_beam(beam);
-            while (field.has_beams()) {
-                field.move_beams();
-            }
-            max_score = std::max(max_score, field.energy_level());
+        for (const auto &beam: edge_beams(field.width(), field.height())) {
+            max_score = std::max(max_score, graph.energy_level(beam));
         }
 
         return static_cast<int>(max_score);
     }
-}
\ No newline at end of file
+
+    int day16_2(const std::vector<std::string> &input, utils::ThreadPool &pool) {
+        const Field field = Field::parse(input);
+        const auto levels = field.energy_levels(edge_beams(field.width(), field.height()), pool);
+        return static_cast<int>(levels.empty() ? 0 : *std::max_element(levels.begin(), levels.end()));
+    }
+}
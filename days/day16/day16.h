@@ -5,9 +5,16 @@
 #ifndef AOC2024_DAY16_H
 #define AOC2024_DAY16_H
 
+#include <cstdint>
+#include <bit>
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 #include <optional>
 #include <list>
+#include <array>
+#include "../../utils/thread_pool.h"
 
 namespace aoc2024::day16 {
 
@@ -22,6 +29,46 @@ namespace aoc2024::day16 {
         RIGHT = 0b1000,
     };
 
+    /***
+     * @brief 0..3 for a [Direction] (to index tables by direction)
+     */
+    inline size_t direction_index(Direction dir) {
+        return std::countr_zero(static_cast<unsigned>(dir));
+    }
+
+    inline Direction opposite(Direction dir) {
+        switch (dir) {
+            case Direction::UP:
+                return Direction::DOWN;
+            case Direction::DOWN:
+                return Direction::UP;
+            case Direction::LEFT:
+                return Direction::RIGHT;
+            case Direction::RIGHT:
+                return Direction::LEFT;
+        }
+        return dir;
+    }
+
+    /***
+     * @brief the cell (y * width + x) next to `cell` in direction `dir` (nullopt if that is outside of the field)
+     */
+    inline std::optional<size_t> step(size_t cell, Direction dir, size_t width, size_t height) {
+        const size_t x = cell % width;
+        const size_t y = cell / width;
+        switch (dir) {
+            case Direction::UP:
+                return y > 0 ? std::optional(cell - width) : std::nullopt;
+            case Direction::DOWN:
+                return y + 1 < height ? std::optional(cell + width) : std::nullopt;
+            case Direction::LEFT:
+                return x > 0 ? std::optional(cell - 1) : std::nullopt;
+            case Direction::RIGHT:
+                return x + 1 < width ? std::optional(cell + 1) : std::nullopt;
+        }
+        return std::nullopt;
+    }
+
     enum class FieldType {
         SPACE,
         REFLECTOR_UPWARDS,
@@ -30,16 +77,155 @@ namespace aoc2024::day16 {
         SPLITTER_HORIZONTAL,
     };
 
+    /***
+     * @brief The direction(s) a beam leaves a cell of `type` in, if it entered it going `dir`
+     * (the second one only for splitters)
+     */
+    inline std::pair<Direction, std::optional<Direction>> outgoing(FieldType type, Direction dir) {
+        switch (type) {
+            case FieldType::SPACE:
+                return {dir, std::nullopt};
+            case FieldType::REFLECTOR_UPWARDS: // `/`
+                switch (dir) {
+                    case Direction::UP:
+                        return {Direction::RIGHT, std::nullopt};
+                    case Direction::DOWN:
+                        return {Direction::LEFT, std::nullopt};
+                    case Direction::LEFT:
+                        return {Direction::DOWN, std::nullopt};
+                    case Direction::RIGHT:
+                        return {Direction::UP, std::nullopt};
+                }
+                break;
+            case FieldType::REFLECTOR_DOWNWARDS: // `\`
+                switch (dir) {
+                    case Direction::UP:
+                        return {Direction::LEFT, std::nullopt};
+                    case Direction::DOWN:
+                        return {Direction::RIGHT, std::nullopt};
+                    case Direction::LEFT:
+                        return {Direction::UP, std::nullopt};
+                    case Direction::RIGHT:
+                        return {Direction::DOWN, std::nullopt};
+                }
+                break;
+            case FieldType::SPLITTER_HORIZONTAL: // `-`
+                if (dir == Direction::UP || dir == Direction::DOWN) {
+                    return {Direction::LEFT, Direction::RIGHT};
+                }
+                return {dir, std::nullopt};
+            case FieldType::SPLITTER_VERTICAL: // `|`
+                if (dir == Direction::LEFT || dir == Direction::RIGHT) {
+                    return {Direction::UP, Direction::DOWN};
+                }
+                return {dir, std::nullopt};
+        }
+        return {dir, std::nullopt};
+    }
+
     struct Beam {
         size_t x;
         size_t y;
         Direction dir;
+
+        /// set by [Field::add_beam], only used for traces
+        uint32_t id = 0;
+    };
+
+    class BeamTraceWriter;
+
+    /***
+     * @brief Everything a simulation on a [Field] writes to (the field itself stays read only)
+     *
+     * Several simulations (e.g. one per thread) can run on the same field, each with its own state.
+     */
+    struct BeamState {
+        /// we do a list here so we can remove beams that have been visited from all directions without
+        /// reclaiming memory
+        std::list<Beam> beams;
+
+        /// key to remember which directions we have visited (i.e., which paths we have already taken)
+        /// if we have visited a field from all directions, we can remove it from the list of beams
+        /// if we do not do this, we will have a lot of duplicate paths (i.e., we will not finish)
+        /// visited[direction_index(d)] is a bitset over all cells (bit `cell % 64` of word `cell / 64`)
+        std::array<std::vector<uint64_t>, 4> visited;
+
+        /// beams [Field::propagate] still has to follow (kept here to reuse its memory)
+        std::vector<Beam> pending;
+        bool first_move = true;
+
+        /// number of [Field::move_beams] calls so far
+        uint32_t frame = 0;
+        uint32_t next_beam_id = 0;
+
+        /// if set, [Field::move_beams] and [Field::add_beam] record what they do (kept by [reset])
+        BeamTraceWriter *trace = nullptr;
+
+        /***
+         * @brief Forgets the last simulation and makes room for a field of `cells` cells
+         */
+        void reset(size_t cells) {
+            const size_t words = (cells + 63) / 64;
+            for (auto &plane: visited) {
+                plane.assign(words, 0);
+            }
+            beams.clear();
+            pending.clear();
+            first_move = true;
+            frame = 0;
+            next_beam_id = 0;
+        }
+
+        [[nodiscard]] bool is_visited(size_t cell, Direction dir) const {
+            return (visited[direction_index(dir)][cell / 64] >> (cell % 64)) & 1;
+        }
+
+        void visit(size_t cell, Direction dir) {
+            const uint64_t bit = uint64_t{1} << (cell % 64);
+            visited[direction_index(dir)][cell / 64] |= bit;
+        }
+
+        [[nodiscard]] size_t words() const {
+            return visited[0].size();
+        }
+
+        /***
+         * @brief Word `word` of the energized plane (the OR of the [visited] planes)
+         *
+         * Built on demand: keeping a fifth plane up to date costs a second cache line per visited cell.
+         */
+        [[nodiscard]] uint64_t energized(size_t word) const {
+            return visited[0][word] | visited[1][word] | visited[2][word] | visited[3][word];
+        }
+
+        [[nodiscard]] bool is_energized(size_t cell) const {
+            return (energized(cell / 64) >> (cell % 64)) & 1;
+        }
+
+        /***
+         * @brief The visited directions of `cell` OR-ed together (as in [Direction])
+         */
+        [[nodiscard]] uint8_t visit_state(size_t cell) const {
+            uint8_t result = 0;
+            for (size_t i = 0; i < 4; ++i) {
+                result |= ((visited[i][cell / 64] >> (cell % 64)) & 1) << i;
+            }
+            return result;
+        }
     };
 
     class Field {
     public:
+        /// marks "no cell" in the jump tables
+        static constexpr uint32_t NO_CELL = UINT32_MAX;
+
         static Field parse(const std::vector<std::string> &input);
 
+        /***
+         * @brief Parses a field from lines which are views into a bigger buffer (e.g. [utils::MappedLines])
+         */
+        static Field parse(std::span<const std::string_view> input);
+
 
         [[nodiscard]] size_t width() const {
             return m_width;
@@ -53,15 +239,22 @@ namespace aoc2024::day16 {
             m_width = width;
             m_height = height;
             m_field = std::vector<FieldType>(width * height);
-            m_visited_states = std::vector<uint8_t>(width * height);
             std::fill(m_field.begin(), m_field.end(), FieldType::SPACE);
+            build_jump_tables();
             reset();
         }
 
         void reset() {
-            std::fill(m_visited_states.begin(), m_visited_states.end(), 0);
-            m_beams = {};
-            first_move = true;
+            m_state.reset(width() * height());
+        }
+
+        /***
+         * @brief A fresh [BeamState] for simulations on this field
+         */
+        [[nodiscard]] BeamState new_state() const {
+            BeamState state;
+            state.reset(width() * height());
+            return state;
         }
 
         [[nodiscard]] std::optional<FieldType> get(size_t x, size_t y) const {
@@ -71,43 +264,97 @@ namespace aoc2024::day16 {
             return m_field[y * width() + x];
         }
 
+        /***
+         * @brief Changes a cell; keeps the jump tables up to date (by rescanning its row and column)
+         */
         void set(size_t x, size_t y, FieldType type) {
             m_field[y * width() + x] = type;
+            if (m_jumps_valid) {
+                update_jump_tables(x, y);
+            }
         }
 
         [[nodiscard]] bool is_energized(size_t x, size_t y) const {
-            return m_visited_states[y * width() + x] > 0;
+            return is_energized(m_state, x, y);
+        }
+
+        [[nodiscard]] bool is_energized(const BeamState &state, size_t x, size_t y) const {
+            return state.is_energized(y * width() + x);
         }
 
         /***
          * adds a [Beam] if it is not out of bounds
          * **/
         void add_beam(Beam beam) {
-            if (beam.x >= width() || beam.y >= height()) {
-                return;
-            }
-            m_beams.push_back(beam);
+            add_beam(m_state, beam);
+        }
+
+        void add_beam(BeamState &state, Beam beam) const;
+
+        /***
+         * @brief Records every following [move_beams] (on the field's own state) to `writer` (nullptr stops that)
+         * @param writer
+         */
+        void trace(BeamTraceWriter *writer) {
+            m_state.trace = writer;
         }
 
         /***
          * will do one `frame`
          */
-        void move_beams();
+        void move_beams() {
+            move_beams(m_state);
+        }
+
+        void move_beams(BeamState &state) const;
+
+        /***
+         * @brief Follows `start` (and everything it splits into) until all beams left the field or loop
+         *
+         * Same result as calling [move_beams] until there are no beams left, but a beam jumps straight to the next
+         * mirror / splitter (see [build_jump_tables]) instead of moving one cell per frame, and pending beams live
+         * on a flat stack instead of a list.
+         * Only the visited states (and so [energy_level]) are updated; [beams] stays untouched.
+         *
+         * @param start
+         */
+        void propagate(Beam start) {
+            propagate(m_state, start);
+        }
+
+        /***
+         * @brief [propagate] on `state` instead of the field's own state (does not change the field, so
+         * any number of threads may do this at once, each with its own state)
+         */
+        void propagate(BeamState &state, Beam start) const;
 
-        [[nodiscard]] bool has_beams() {
-            return !m_beams.empty();
+        /***
+         * @brief The energy level of every start (each simulated on its own), spread over `pool`
+         *
+         * Every worker reuses one [BeamState]; results are in the order of `starts` no matter which worker
+         * did what.
+         *
+         * @param starts
+         * @param pool
+         * @return
+         */
+        [[nodiscard]] std::vector<size_t> energy_levels(const std::vector<Beam> &starts,
+                                                        utils::ThreadPool &pool) const;
+
+        [[nodiscard]] bool has_beams() const {
+            return !m_state.beams.empty();
         }
 
         [[nodiscard]] std::list<Beam> beams() const {
-            return m_beams;
+            return m_state.beams;
         }
 
-        [[nodiscard]] uint8_t get_visit_state(uint8_t x, uint8_t y) const {
-            return m_visited_states[y * width() + x];
+        [[nodiscard]] uint8_t get_visit_state(size_t x, size_t y) const {
+            return m_state.visit_state(y * width() + x);
         }
 
-        void add_visited_state(uint8_t x, uint8_t y, Direction d) {
-            m_visited_states[y * width() + x] |= static_cast<uint8_t>(d);
+        void add_visited_state(size_t x, size_t y, Direction d) {
+            m_state.visit(y * width() + x, d);
         }
 
         /***
@@ -116,37 +363,87 @@ namespace aoc2024::day16 {
          * if multiple beams are on the same position, a number will be printed
          * @return
          */
-        [[nodiscard]] std::string to_string() const;
+        [[nodiscard]] std::string to_string() const {
+            return to_string(m_state);
+        }
+
+        [[nodiscard]] std::string to_string(const BeamState &state) const;
 
-        [[nodiscard]] std::string to_visited_map_string() const;
+        [[nodiscard]] std::string to_visited_map_string() const {
+            return to_visited_map_string(m_state);
+        }
+
+        [[nodiscard]] std::string to_visited_map_string(const BeamState &state) const;
 
         /***
          * returns the field with energized fields marked with a `#`
          * @return
          */
-        [[nodiscard]] std::string energy_map() const;
+        [[nodiscard]] std::string energy_map() const {
+            return energy_map(m_state);
+        }
 
-        [[nodiscard]] size_t energy_level() const;
+        [[nodiscard]] std::string energy_map(const BeamState &state) const;
+
+        [[nodiscard]] size_t energy_level() const {
+            return energy_level(m_state);
+        }
+
+        [[nodiscard]] size_t energy_level(const BeamState &state) const;
 
     private:
+        /***
+         * @brief [parse] for any container of lines
+         */
+        template<typename Lines>
+        static Field parse_lines(const Lines &input);
+
+        /***
+         * @brief For every cell and direction, remembers the next cell which is not [FieldType::SPACE]
+         */
+        void build_jump_tables();
+
+        /***
+         * @brief Rescans the jump tables of row `y` and column `x` (after (x, y) changed)
+         */
+        void update_jump_tables(size_t x, size_t y);
+
+        /***
+         * @brief Rescans the jump table of `dir` for one row (LEFT / RIGHT) or column (UP / DOWN)
+         */
+        void scan_jump_line(Direction dir, size_t line);
 
         std::vector<FieldType> m_field;
 
-        /// we do a list here so we can remove beams that have been visited from all directions without
-        /// reclaiming memory
-        std::list<Beam> m_beams;
+        /// m_jumps[direction_index(d)][y * width + x] = index of the next non-space cell after (x, y) in direction d
+        /// (or NO_CELL if we only see space until the border)
+        std::array<std::vector<uint32_t>, 4> m_jumps;
 
-        /// key to remember which directions we have visited (i.e., which paths we have already taken)
-        /// if we have visited a field from all directions, we can remove it from the list of beams
-        /// if we do not do this, we will have a lot of duplicate paths (i.e., we will not finish)
-        std::vector<uint8_t> m_visited_states;
-        size_t m_width;
-        size_t m_height;
-        bool first_move = true;
+        /// only false while [parse] fills the field (it builds the tables once at the end)
+        bool m_jumps_valid = false;
+
+        /// state of the simulation run by the member functions without a [BeamState] parameter
+        BeamState m_state;
+        size_t m_width = 0;
+        size_t m_height = 0;
     };
 
     int day16_1(const std::vector<std::string> &input);
 
+    /***
+     * @brief All beams entering the field from its border (corners twice), see part 2 of the riddle
+     * @param width
+     * @param height
+     * @return
+     */
+    std::vector<Beam> edge_beams(size_t width, size_t height);
+
     int day16_2(const std::vector<std::string> &input);
+
+    /***
+     * @brief [day16_2] by simulating every border start on its own, spread over `pool`
+     * (slower than the splitter graph on one core, but needs no preprocessing)
+     */
+    int day16_2(const std::vector<std::string> &input, utils::ThreadPool &pool);
 }
 #endif //AOC2024_DAY16_H
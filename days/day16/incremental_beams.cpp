@@ -0,0 +1,278 @@
+#include "incremental_beams.h"
+#include <algorithm>
+#include <functional>
+
+namespace aoc2024::day16 {
+    namespace {
+        Direction direction_of(uint32_t node) {
+            return static_cast<Direction>(1u << (node % 4));
+        }
+
+        /***
+         * @brief appends the nodes a beam entering `cell` going `dir` continues as
+         */
+        void exits(size_t cell, FieldType type, Direction dir, std::vector<uint32_t> &out) {
+            const auto [first, second] = outgoing(type, dir);
+            out.push_back(static_cast<uint32_t>(cell * 4 + direction_index(first)));
+            if (second.has_value()) {
+                out.push_back(static_cast<uint32_t>(cell * 4 + direction_index(second.value())));
+            }
+        }
+
+        using HopQueue = std::vector<std::pair<uint32_t, uint32_t>>;
+
+        void push(HopQueue &queue, uint32_t hops, uint32_t node) {
+            queue.emplace_back(hops, node);
+            std::push_heap(queue.begin(), queue.end(), std::greater<>());
+        }
+
+        std::pair<uint32_t, uint32_t> pop(HopQueue &queue) {
+            std::pop_heap(queue.begin(), queue.end(), std::greater<>());
+            const auto top = queue.back();
+            queue.pop_back();
+            return top;
+        }
+    }
+
+    IncrementalBeams::IncrementalBeams(Field field, Beam start) : m_field(std::move(field)), m_start(start) {
+        const size_t cells = m_field.width() * m_field.height();
+        m_start_node = static_cast<uint32_t>(cells * 4);
+        m_hops.assign(cells * 4 + 1, UNREACHED);
+        m_seen.assign(cells * 4 + 1, 0);
+        m_checked.assign(cells * 4 + 1, 0);
+        m_lost.assign(cells * 4 + 1, false);
+        m_coverage.assign(cells, 0);
+        if (start.x >= m_field.width() || start.y >= m_field.height()) {
+            return;
+        }
+
+        ++m_generation;
+        m_hops[m_start_node] = 0;
+        HopQueue queue = {{0, m_start_node}};
+        relax(queue);
+        for (uint32_t node = 0; node < m_start_node; ++node) {
+            if (reached(node)) {
+                cover(node, 1);
+            }
+        }
+        m_changed.clear();
+    }
+
+    template<typename Fn>
+    std::optional<size_t> IncrementalBeams::walk_segment(uint32_t node, Fn &&fn) const {
+        const Direction dir = direction_of(node);
+        size_t cell = node / 4;
+        fn(cell);
+        while (true) {
+            const auto next = step(cell, dir, m_field.width(), m_field.height());
+            if (!next.has_value() || type_at(next.value()) != FieldType::SPACE) {
+                return next;
+            }
+            cell = next.value();
+            fn(cell);
+        }
+    }
+
+    void IncrementalBeams::cover(uint32_t node, int delta) {
+        if (node == m_start_node) {
+            return;
+        }
+        walk_segment(node, [&](size_t cell) {
+            if (delta > 0 && m_coverage[cell]++ == 0) {
+                ++m_energy;
+            } else if (delta < 0 && --m_coverage[cell] == 0) {
+                --m_energy;
+            }
+        });
+    }
+
+    void IncrementalBeams::successors(uint32_t node, std::vector<uint32_t> &out) const {
+        if (node == m_start_node) {
+            const size_t cell = m_start.y * m_field.width() + m_start.x;
+            exits(cell, type_at(cell), m_start.dir, out);
+            return;
+        }
+        const auto next = walk_segment(node, [](size_t) {});
+        if (next.has_value()) {
+            exits(next.value(), type_at(next.value()), direction_of(node), out);
+        }
+    }
+
+    void IncrementalBeams::predecessors(uint32_t node, std::vector<uint32_t> &out) const {
+        if (node == m_start_node) {
+            return;
+        }
+        const size_t cell = node / 4;
+        const size_t start_cell = m_start.y * m_field.width() + m_start.x;
+        const Direction dir = direction_of(node);
+        const FieldType type = type_at(cell);
+        if (type == FieldType::SPACE) {
+            // beams run through space, only the start beam may leave from there
+            if (cell == start_cell && dir == m_start.dir) {
+                out.push_back(m_start_node);
+            }
+            return;
+        }
+
+        for (const auto entering: {Direction::UP, Direction::DOWN, Direction::LEFT, Direction::RIGHT}) {
+            const auto [first, second] = outgoing(type, entering);
+            if (first != dir && second != dir) {
+                continue;
+            }
+            if (cell == start_cell && entering == m_start.dir) {
+                out.push_back(m_start_node);
+            }
+            arriving(cell, entering, out);
+        }
+    }
+
+    void IncrementalBeams::arriving(size_t cell, Direction dir, std::vector<uint32_t> &out) const {
+        const size_t w = m_field.width();
+        const size_t h = m_field.height();
+        const size_t start_cell = m_start.y * w + m_start.x;
+        // the beam came from the closest non-space cell behind us (or the start cell on the way)
+        auto behind = step(cell, opposite(dir), w, h);
+        while (behind.has_value()) {
+            const bool blocked = type_at(behind.value()) != FieldType::SPACE;
+            if (blocked || behind.value() == start_cell) {
+                out.push_back(node_of(behind.value(), dir));
+            }
+            if (blocked) {
+                break;
+            }
+            behind = step(behind.value(), opposite(dir), w, h);
+        }
+    }
+
+    void IncrementalBeams::remember(uint32_t node, bool counted) {
+        if (m_seen[node] != m_generation) {
+            m_seen[node] = m_generation;
+            m_changed.emplace_back(node, counted);
+        }
+    }
+
+    void IncrementalBeams::relax(std::vector<std::pair<uint32_t, uint32_t>> &queue) {
+        std::make_heap(queue.begin(), queue.end(), std::greater<>());
+        std::vector<uint32_t> next;
+        while (!queue.empty()) {
+            const auto [hops, node] = pop(queue);
+            if (hops != m_hops[node]) {
+                continue; // found a shorter way in the meantime
+            }
+            next.clear();
+            successors(node, next);
+            for (const auto successor: next) {
+                if (hops + 1 < m_hops[successor]) {
+                    remember(successor, reached(successor));
+                    m_hops[successor] = hops + 1;
+                    push(queue, hops + 1, successor);
+                }
+            }
+        }
+    }
+
+    void IncrementalBeams::set(size_t x, size_t y, FieldType type) {
+        const size_t w = m_field.width();
+        const size_t cell = y * w + x;
+        ++m_generation;
+        m_changed.clear();
+        if (m_field.get(x, y) == type) {
+            return;
+        }
+
+        // the nodes leaving the cell and the ones running into / through it are the only ones whose segment or
+        // successors depend on the cell
+        std::vector<uint32_t> sources;
+        for (const auto dir: {Direction::UP, Direction::DOWN, Direction::LEFT, Direction::RIGHT}) {
+            sources.push_back(node_of(cell, dir));
+            arriving(cell, dir, sources);
+        }
+        if (cell == m_start.y * w + m_start.x) {
+            sources.push_back(m_start_node);
+        }
+        std::erase_if(sources, [&](uint32_t node) { return !reached(node); });
+        std::sort(sources.begin(), sources.end());
+        sources.erase(std::unique(sources.begin(), sources.end()), sources.end());
+
+        // forget their segments and where they lead to while the field still is what those were built on
+        std::vector<uint32_t> old_successors;
+        for (const auto node: sources) {
+            successors(node, old_successors);
+            cover(node, -1);
+            remember(node, false);
+        }
+
+        m_field.set(x, y, type);
+
+        // the old successors may have lost the node leading to them with one hop less; whoever did, and
+        // everything that was only reached through them, is lost until we find a new way there
+        HopQueue queue;
+        for (const auto node: old_successors) {
+            if (reached(node)) {
+                push(queue, m_hops[node], node);
+            }
+        }
+        std::vector<uint32_t> lost;
+        std::vector<uint32_t> neighbours;
+        while (!queue.empty()) {
+            const auto [hops, node] = pop(queue);
+            if (m_checked[node] == m_generation) {
+                continue;
+            }
+            m_checked[node] = m_generation;
+            neighbours.clear();
+            predecessors(node, neighbours);
+            const bool supported = std::any_of(neighbours.begin(), neighbours.end(), [&](uint32_t predecessor) {
+                return reached(predecessor) && !m_lost[predecessor] && m_hops[predecessor] + 1 == hops;
+            });
+            if (supported) {
+                continue;
+            }
+            m_lost[node] = true;
+            lost.push_back(node);
+            neighbours.clear();
+            successors(node, neighbours);
+            for (const auto successor: neighbours) {
+                if (reached(successor) && m_hops[successor] == hops + 1) {
+                    push(queue, hops + 1, successor);
+                }
+            }
+        }
+
+        // lost nodes get the best hops their remaining predecessors offer, then everything is relaxed from them
+        // and from the changed nodes (which may lead somewhere new now)
+        for (const auto node: lost) {
+            remember(node, true);
+            m_hops[node] = UNREACHED;
+        }
+        for (const auto node: lost) {
+            neighbours.clear();
+            predecessors(node, neighbours);
+            for (const auto predecessor: neighbours) {
+                if (reached(predecessor) && !m_lost[predecessor]) {
+                    m_hops[node] = std::min(m_hops[node], m_hops[predecessor] + 1);
+                }
+            }
+            if (reached(node)) {
+                queue.emplace_back(m_hops[node], node);
+            }
+        }
+        for (const auto node: lost) {
+            m_lost[node] = false;
+        }
+        for (const auto node: sources) {
+            if (reached(node)) {
+                queue.emplace_back(m_hops[node], node);
+            }
+        }
+        relax(queue);
+
+        for (const auto &[node, counted]: m_changed) {
+            if (reached(node) && !counted) {
+                cover(node, 1);
+            } else if (!reached(node) && counted) {
+                cover(node, -1);
+            }
+        }
+    }
+}
@@ -0,0 +1,133 @@
+#ifndef AOC2024_DAY16_INCREMENTAL_BEAMS_H
+#define AOC2024_DAY16_INCREMENTAL_BEAMS_H
+
+#include <cstdint>
+#include <vector>
+#include "day16.h"
+
+namespace aoc2024::day16 {
+
+    /***
+     * @brief The energized cells of one start beam, kept up to date while single cells of the field change
+     *
+     * A node is a cell together with a direction a beam leaves it in; it exists for every mirror / splitter a beam
+     * hits and for the start cell. Its segment are the cells from there until (excluding) the next non-space cell.
+     * For every node we remember how many hops away from the start beam it is (or that it is not reached at all)
+     * and for every cell how many reached segments cover it, so the energy level is the number of cells with a
+     * count above zero.
+     *
+     * Beams loop, so "still reached" can not be decided by counting the nodes leading to a node. The hop counts can:
+     * a node with `n` hops stays as it is as long as a node with `n - 1` hops still leads to it. Changing a cell
+     * only changes where the nodes running into / through it lead, so only nodes that lost all of those
+     * supporters (and, recursively, the ones they supported) get their hop count computed again.
+     */
+    class IncrementalBeams {
+    public:
+        IncrementalBeams(Field field, Beam start);
+
+        /***
+         * @brief Changes one cell and updates the energized cells
+         * @param x
+         * @param y
+         * @param type
+         */
+        void set(size_t x, size_t y, FieldType type);
+
+        [[nodiscard]] size_t energy_level() const {
+            return m_energy;
+        }
+
+        [[nodiscard]] bool is_energized(size_t x, size_t y) const {
+            return m_coverage[y * m_field.width() + x] > 0;
+        }
+
+        [[nodiscard]] const Field &field() const {
+            return m_field;
+        }
+
+        /***
+         * @brief number of nodes the last [set] had to look at again
+         */
+        [[nodiscard]] size_t last_changed() const {
+            return m_changed.size();
+        }
+
+    private:
+        static constexpr uint32_t UNREACHED = UINT32_MAX;
+
+        [[nodiscard]] uint32_t node_of(size_t cell, Direction dir) const {
+            return static_cast<uint32_t>(cell * 4 + direction_index(dir));
+        }
+
+        [[nodiscard]] FieldType type_at(size_t cell) const {
+            return m_field.get(cell % m_field.width(), cell / m_field.width()).value();
+        }
+
+        [[nodiscard]] bool reached(uint32_t node) const {
+            return m_hops[node] != UNREACHED;
+        }
+
+        /***
+         * @brief Walks the segment of `node` and calls `fn(cell)` for each of its cells
+         * @return the non-space cell the segment runs into (nullopt if it leaves the field)
+         */
+        template<typename Fn>
+        std::optional<size_t> walk_segment(uint32_t node, Fn &&fn) const;
+
+        /***
+         * @brief adds `delta` to the coverage of every cell in the segment of `node`
+         */
+        void cover(uint32_t node, int delta);
+
+        /***
+         * @brief appends the nodes `node` leads to (for the current field)
+         */
+        void successors(uint32_t node, std::vector<uint32_t> &out) const;
+
+        /***
+         * @brief appends the nodes leading to `node` (for the current field), the start node included
+         */
+        void predecessors(uint32_t node, std::vector<uint32_t> &out) const;
+
+        /***
+         * @brief appends the nodes whose segment runs into `cell` (or through it, if it is space) going `dir`
+         */
+        void arriving(size_t cell, Direction dir, std::vector<uint32_t> &out) const;
+
+        /***
+         * @brief remembers whether the segment of `node` is counted in [m_coverage] before we change its hops
+         */
+        void remember(uint32_t node, bool counted);
+
+        /***
+         * @brief Lowers the hops of everything reachable from `queue` (pairs of hops and node) where possible
+         */
+        void relax(std::vector<std::pair<uint32_t, uint32_t>> &queue);
+
+        Field m_field;
+        Beam m_start;
+
+        /// pseudo node standing for the start beam (no segment, it leads to the nodes on the start cell)
+        uint32_t m_start_node;
+
+        /// hops from the start node (UNREACHED if there is no way to get there)
+        std::vector<uint32_t> m_hops;
+
+        /// number of reached segments covering a cell
+        std::vector<uint32_t> m_coverage;
+        size_t m_energy = 0;
+
+        /// scratch of [set]: nodes whose hops may change and whether their segment was counted before
+        std::vector<std::pair<uint32_t, bool>> m_changed;
+
+        /// m_seen[node] == m_generation if the node is in m_changed (resp. m_checked) for the current [set]
+        std::vector<uint32_t> m_seen;
+        std::vector<uint32_t> m_checked;
+        uint32_t m_generation = 0;
+
+        /// nodes [set] found to be cut off from all nodes leading to them with one hop less
+        std::vector<bool> m_lost;
+    };
+}
+
+#endif //AOC2024_DAY16_INCREMENTAL_BEAMS_H
@@ -0,0 +1,234 @@
+#include "splitter_graph.h"
+#include <algorithm>
+#include <bit>
+#include <limits>
+
+namespace aoc2024::day16 {
+    namespace {
+        constexpr uint32_t NO_NODE = std::numeric_limits<uint32_t>::max();
+
+        bool is_splitter(FieldType type) {
+            return type == FieldType::SPLITTER_HORIZONTAL || type == FieldType::SPLITTER_VERTICAL;
+        }
+    }
+
+    uint32_t SplitterGraph::node_of(size_t cell, Direction dir) const {
+        const bool second = dir == Direction::RIGHT || dir == Direction::DOWN;
+        return 2 * m_splitter_of[cell] + (second ? 1 : 0);
+    }
+
+    void SplitterGraph::trace(size_t cell, Direction dir, std::vector<uint32_t> &cells,
+                              std::vector<uint32_t> &next) const {
+        const size_t w = m_width;
+        const size_t h = m_height;
+        // a beam coming from a splitter or the border can not end up in a loop of mirrors (we could follow
+        // every loop backwards forever), but better safe than sorry
+        for (size_t steps = 0; steps <= 4 * w * h; ++steps) {
+            cells.push_back(static_cast<uint32_t>(cell));
+            const FieldType type = m_cells[cell];
+            const auto [first, second] = outgoing(type, dir);
+            if (is_splitter(type)) {
+                next.push_back(node_of(cell, first));
+                if (second.has_value()) {
+                    next.push_back(node_of(cell, second.value()));
+                }
+                return;
+            }
+            const auto following = step(cell, first, w, h);
+            if (!following.has_value()) {
+                return;
+            }
+            cell = following.value();
+            dir = first;
+        }
+    }
+
+    SplitterGraph::SplitterGraph(const Field &field, size_t max_bytes)
+            : m_width(field.width()), m_height(field.height()) {
+        const size_t w = m_width;
+        const size_t h = m_height;
+        m_words = (w * h + 63) / 64;
+        m_cells.resize(w * h);
+        for (size_t cell = 0; cell < w * h; ++cell) {
+            m_cells[cell] = field.get(cell % w, cell / w).value();
+        }
+
+        std::vector<size_t> splitters;
+        m_splitter_of.assign(w * h, NO_NODE);
+        for (size_t cell = 0; cell < w * h; ++cell) {
+            if (is_splitter(m_cells[cell])) {
+                m_splitter_of[cell] = static_cast<uint32_t>(splitters.size());
+                splitters.push_back(cell);
+            }
+        }
+
+        // follow every node until the next splitter
+        const size_t nodes = 2 * splitters.size();
+        std::vector<std::vector<uint32_t>> own_cells(nodes);
+        std::vector<std::vector<uint32_t>> successors(nodes);
+        for (const auto cell: splitters) {
+            const bool horizontal = m_cells[cell] == FieldType::SPLITTER_HORIZONTAL;
+            for (const auto dir: horizontal ? std::array{Direction::LEFT, Direction::RIGHT}
+                                            : std::array{Direction::UP, Direction::DOWN}) {
+                const auto node = node_of(cell, dir);
+                own_cells[node].push_back(static_cast<uint32_t>(cell));
+                const auto next = step(cell, dir, w, h);
+                if (next.has_value()) {
+                    trace(next.value(), dir, own_cells[node], successors[node]);
+                }
+            }
+        }
+
+        // Tarjan's strongly connected components (without recursion, the graph may be deep);
+        // components are finished sinks first, so all components a component leads to already have their cells
+        m_component_of.assign(nodes, NO_NODE);
+        std::vector<uint32_t> index(nodes, NO_NODE);
+        std::vector<uint32_t> low(nodes, 0);
+        std::vector<bool> on_stack(nodes, false);
+        std::vector<uint32_t> stack;
+        std::vector<std::pair<uint32_t, size_t>> call_stack; // node and the next successor to look at
+        uint32_t next_index = 0;
+
+        const auto finish_component = [&](uint32_t root) {
+            const auto component = static_cast<uint32_t>(m_component_next.size());
+            std::vector<uint32_t> members;
+            uint32_t member;
+            do {
+                member = stack.back();
+                stack.pop_back();
+                on_stack[member] = false;
+                m_component_of[member] = component;
+                members.push_back(member);
+            } while (member != root);
+
+            std::vector<uint32_t> cells;
+            std::vector<uint32_t> next;
+            for (const auto node: members) {
+                cells.insert(cells.end(), own_cells[node].begin(), own_cells[node].end());
+                for (const auto successor: successors[node]) {
+                    if (m_component_of[successor] != component) {
+                        next.push_back(m_component_of[successor]);
+                    }
+                }
+            }
+            for (auto *list: {&cells, &next}) {
+                std::sort(list->begin(), list->end());
+                list->erase(std::unique(list->begin(), list->end()), list->end());
+                list->shrink_to_fit();
+            }
+            m_component_own_cells.push_back(std::move(cells));
+            m_component_next.push_back(std::move(next));
+        };
+
+        for (uint32_t root = 0; root < nodes; ++root) {
+            if (index[root] != NO_NODE) {
+                continue;
+            }
+            call_stack.emplace_back(root, 0);
+            index[root] = low[root] = next_index++;
+            stack.push_back(root);
+            on_stack[root] = true;
+
+            while (!call_stack.empty()) {
+                auto &[node, next_successor] = call_stack.back();
+                if (next_successor < successors[node].size()) {
+                    const auto successor = successors[node][next_successor++];
+                    if (index[successor] == NO_NODE) {
+                        index[successor] = low[successor] = next_index++;
+                        stack.push_back(successor);
+                        on_stack[successor] = true;
+                        call_stack.emplace_back(successor, 0);
+                    } else if (on_stack[successor]) {
+                        low[node] = std::min(low[node], index[successor]);
+                    }
+                    continue;
+                }
+
+                const uint32_t done = node;
+                call_stack.pop_back();
+                if (low[done] == index[done]) {
+                    finish_component(done);
+                }
+                if (!call_stack.empty()) {
+                    const uint32_t parent = call_stack.back().first;
+                    low[parent] = std::min(low[parent], low[done]);
+                }
+            }
+        }
+
+        // the components with the most cells of their own get a bitset (those are the expensive ones to union cell
+        // by cell); in finishing order, so the bitsets of the components they lead to are there already
+        const size_t components = m_component_next.size();
+        const size_t max_bitsets = std::min(components, m_words > 0 ? max_bytes / (m_words * sizeof(uint64_t)) : 0);
+        std::vector<uint32_t> by_size(components);
+        for (uint32_t component = 0; component < components; ++component) {
+            by_size[component] = component;
+        }
+        std::partial_sort(by_size.begin(), by_size.begin() + max_bitsets, by_size.end(), [&](uint32_t a, uint32_t b) {
+            return m_component_own_cells[a].size() > m_component_own_cells[b].size();
+        });
+        std::sort(by_size.begin(), by_size.begin() + max_bitsets);
+
+        m_bitset_of.assign(components, NO_NODE);
+        std::vector<bool> seen;
+        for (size_t i = 0; i < max_bitsets; ++i) {
+            const uint32_t component = by_size[i];
+            std::vector<uint64_t> bits(m_words, 0);
+            seen.assign(components, false);
+            add_cells(component, bits, seen);
+            m_bitset_of[component] = static_cast<uint32_t>(m_component_cells.size());
+            m_component_cells.push_back(std::move(bits));
+            // the bitset has them
+            m_component_own_cells[component] = {};
+        }
+    }
+
+    void SplitterGraph::add_cells(uint32_t component, std::vector<uint64_t> &bits, std::vector<bool> &seen) const {
+        std::vector<uint32_t> pending = {component};
+        while (!pending.empty()) {
+            const uint32_t current = pending.back();
+            pending.pop_back();
+            if (seen[current]) {
+                continue;
+            }
+            seen[current] = true;
+            if (m_bitset_of[current] != NO_NODE) {
+                const auto &component_bits = m_component_cells[m_bitset_of[current]];
+                for (size_t i = 0; i < m_words; ++i) {
+                    bits[i] |= component_bits[i];
+                }
+                continue;
+            }
+            for (const auto cell: m_component_own_cells[current]) {
+                bits[cell / 64] |= uint64_t{1} << (cell % 64);
+            }
+            pending.insert(pending.end(), m_component_next[current].begin(), m_component_next[current].end());
+        }
+    }
+
+    size_t SplitterGraph::energy_level(Beam start) const {
+        const size_t w = m_width;
+        if (start.x >= w || start.y >= m_height) {
+            return 0;
+        }
+
+        std::vector<uint32_t> cells;
+        std::vector<uint32_t> next;
+        trace(start.y * w + start.x, start.dir, cells, next);
+
+        std::vector<uint64_t> bits(m_words, 0);
+        for (const auto cell: cells) {
+            bits[cell / 64] |= uint64_t{1} << (cell % 64);
+        }
+        std::vector<bool> seen(m_component_next.size(), false);
+        for (const auto node: next) {
+            add_cells(m_component_of[node], bits, seen);
+        }
+
+        size_t energy = 0;
+        for (const auto word: bits) {
+            energy += std::popcount(word);
+        }
+        return energy;
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef AOC2024_DAY16_SPLITTER_GRAPH_H
+#define AOC2024_DAY16_SPLITTER_GRAPH_H
+
+#include <cstdint>
+#include <vector>
+#include "day16.h"
+
+namespace aoc2024::day16 {
+
+    /***
+     * @brief Condensed beam graph of a [Field] to answer "how many cells does this beam energize" for many starts
+     *
+     * Every node is a splitter together with a direction a beam leaves it in. Following that beam (through mirrors)
+     * until it hits the next splitter gives the cells the node energizes on its own and the nodes it continues as.
+     * Beams can loop, so we collapse the strongly connected components of that graph and compute, sinks first,
+     * the bitset of all cells a beam starting in a component energizes.
+     * A start beam then only has to be followed until its first splitter and OR-ed with (at most two) components.
+     *
+     * A bitset per component is W * H bits, so only as many as fit into `max_bytes` are kept, for the components
+     * with the most cells of their own. All other components keep their own cells and the components they lead to,
+     * and a query unions those until it reaches components with a bitset. The graph copies the cells it needs, it
+     * does not refer to the field it was built from.
+     */
+    class SplitterGraph {
+    public:
+        /// default memory for the component bitsets
+        static constexpr size_t DEFAULT_MAX_BYTES = size_t{256} << 20;
+
+        explicit SplitterGraph(const Field &field, size_t max_bytes = DEFAULT_MAX_BYTES);
+
+        /***
+         * @brief Same as [Field::propagate] `start` on a fresh field followed by [Field::energy_level]
+         * @param start
+         * @return
+         */
+        [[nodiscard]] size_t energy_level(Beam start) const;
+
+        [[nodiscard]] size_t node_count() const {
+            return m_component_of.size();
+        }
+
+        [[nodiscard]] size_t component_count() const {
+            return m_component_next.size();
+        }
+
+        /***
+         * @brief number of components whose cells are kept as a bitset
+         */
+        [[nodiscard]] size_t bitset_count() const {
+            return m_component_cells.size();
+        }
+
+    private:
+        /***
+         * @brief Follows a beam entering `cell` going `dir` until it hits a splitter or leaves the field
+         * @param cells receives every cell the beam passes (including the splitter)
+         * @param next receives the nodes the beam continues as
+         */
+        void trace(size_t cell, Direction dir, std::vector<uint32_t> &cells, std::vector<uint32_t> &next) const;
+
+        [[nodiscard]] uint32_t node_of(size_t cell, Direction dir) const;
+
+        /***
+         * @brief ORs everything a beam in `component` energizes into `bits`, skipping the components in `seen`
+         *        (and marking the ones it visits)
+         */
+        void add_cells(uint32_t component, std::vector<uint64_t> &bits, std::vector<bool> &seen) const;
+
+        size_t m_width;
+        size_t m_height;
+        std::vector<FieldType> m_cells;
+        size_t m_words;
+
+        /// splitter number of every cell (only valid for splitter cells); node = 2 * splitter + (0 | 1)
+        std::vector<uint32_t> m_splitter_of;
+
+        std::vector<uint32_t> m_component_of;
+
+        /// m_component_cells[m_bitset_of[c]] = bitset (m_words words) of everything a beam in component c energizes
+        /// (m_bitset_of[c] is UINT32_MAX for components without one)
+        std::vector<std::vector<uint64_t>> m_component_cells;
+        std::vector<uint32_t> m_bitset_of;
+
+        /// cells the nodes of a component energize themselves (only kept for components without a bitset)
+        std::vector<std::vector<uint32_t>> m_component_own_cells;
+
+        /// components a component leads to (all finished before it)
+        std::vector<std::vector<uint32_t>> m_component_next;
+    };
+}
+
+#endif //AOC2024_DAY16_SPLITTER_GRAPH_H
@@ -0,0 +1,394 @@
+#include "axis_graph.h"
+#include "bucket_queue.h"
+#include <algorithm>
+
+namespace aoc2024::day17 {
+    namespace {
+        struct QueuedNode {
+            uint32_t heat;
+            uint32_t node;
+        };
+
+        struct QueuedHeat {
+            size_t operator()(const QueuedNode &queued) const {
+                return queued.heat;
+            }
+        };
+    }
+
+    AxisGraph::AxisGraph(const Field &field, CrucibleRules rules)
+            : m_width(field.width()), m_height(field.height()), m_rules(rules) {
+        m_row_prefix.assign(m_height * (m_width + 1), 0);
+        m_column_prefix.assign(m_width * (m_height + 1), 0);
+        for (size_t y = 0; y < m_height; ++y) {
+            for (size_t x = 0; x < m_width; ++x) {
+                const uint32_t heat = field.get(x, y).heat_loss;
+                m_row_prefix[y * (m_width + 1) + x + 1] = m_row_prefix[y * (m_width + 1) + x] + heat;
+                m_column_prefix[x * (m_height + 1) + y + 1] = m_column_prefix[x * (m_height + 1) + y] + heat;
+            }
+        }
+    }
+
+    void AxisGraph::prepare_bound(size_t to, Heuristic heuristic) {
+        if (!m_bound.empty() && m_bound_heuristic == heuristic && (heuristic == Heuristic::NONE || m_bound_target == to)) {
+            return;
+        }
+        m_bound_target = to;
+        m_bound_heuristic = heuristic;
+        const size_t fields = m_width * m_height;
+        switch (heuristic) {
+            case Heuristic::NONE:
+                m_bound.assign(fields, 0);
+                break;
+            case Heuristic::MANHATTAN: {
+                uint32_t cheapest = MAX_HEAT_LOSS;
+                for (size_t field = 0; field < fields; ++field) {
+                    cheapest = std::min(cheapest, heat_at(field));
+                }
+                m_bound.resize(fields);
+                const size_t to_x = to % m_width;
+                const size_t to_y = to / m_width;
+                for (size_t field = 0; field < fields; ++field) {
+                    const size_t x = field % m_width;
+                    const size_t y = field / m_width;
+                    const size_t distance = (x > to_x ? x - to_x : to_x - x) + (y > to_y ? y - to_y : to_y - y);
+                    m_bound[field] = static_cast<uint32_t>(distance * cheapest);
+                }
+                break;
+            }
+            case Heuristic::REVERSE_DIJKSTRA: {
+                // going from a field to its neighbour costs the neighbour, so backwards we pay the field we leave
+                m_bound.assign(fields, UNREACHABLE);
+                m_bound[to] = 0;
+                BucketQueue<QueuedNode, QueuedHeat> queue(MAX_HEAT_LOSS);
+                queue.push({0, static_cast<uint32_t>(to)});
+                while (!queue.empty()) {
+                    const auto [heat, field] = queue.top();
+                    queue.pop();
+                    if (heat != m_bound[field]) {
+                        continue;
+                    }
+                    const uint32_t next_heat = heat + heat_at(field);
+                    const size_t x = field % m_width;
+                    const size_t y = field / m_width;
+                    const auto relax = [&](size_t neighbour) {
+                        if (next_heat < m_bound[neighbour]) {
+                            m_bound[neighbour] = next_heat;
+                            queue.push({next_heat, static_cast<uint32_t>(neighbour)});
+                        }
+                    };
+                    if (x > 0) {
+                        relax(field - 1);
+                    }
+                    if (x + 1 < m_width) {
+                        relax(field + 1);
+                    }
+                    if (y > 0) {
+                        relax(field - m_width);
+                    }
+                    if (y + 1 < m_height) {
+                        relax(field + m_width);
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    template<typename IsTarget, typename Allowed>
+    uint32_t AxisGraph::search(std::span<const uint32_t> sources, IsTarget &&is_target, Allowed &&allowed) {
+        m_expanded = 0;
+        m_reached = NO_NODE;
+        m_heat.assign(node_count(), UNREACHABLE);
+        // only the parents of nodes reached in this search are read
+        m_parent.resize(node_count());
+
+        // the queue is ordered by heat + bound; both bounds are consistent, so a jump raises that by at most its
+        // own heat plus the heat of going back (which is at most another jump)
+        BucketQueue<QueuedNode, QueuedHeat> queue(2 * max_edge_heat());
+        for (const auto node: sources) {
+            m_heat[node] = 0;
+            m_parent[node] = NO_NODE;
+            queue.push({m_bound[field_of(node)], node});
+        }
+
+        while (!queue.empty()) {
+            const auto [estimate, node] = queue.top();
+            queue.pop();
+            const uint32_t heat = m_heat[node];
+            if (estimate != heat + m_bound[field_of(node)]) {
+                continue; // found a cheaper way in the meantime
+            }
+            if (is_target(field_of(node))) {
+                m_reached = node;
+                return heat;
+            }
+            ++m_expanded;
+            for_each_jump(node, [&](uint32_t next, uint32_t jump_heat) {
+                if (heat + jump_heat < m_heat[next] && allowed(node, next)) {
+                    m_heat[next] = heat + jump_heat;
+                    m_parent[next] = node;
+                    queue.push({heat + jump_heat + m_bound[field_of(next)], next});
+                }
+            });
+        }
+        return UNREACHABLE;
+    }
+
+    namespace {
+        constexpr auto ALL_JUMPS = [](uint32_t, uint32_t) { return true; };
+    }
+
+    uint32_t AxisGraph::min_heat_loss(size_t from, size_t to, Heuristic heuristic) {
+        m_expanded = 0;
+        if (!valid(from) || !valid(to)) {
+            return UNREACHABLE;
+        }
+        prepare_bound(to, heuristic);
+        const uint32_t sources[] = {node_of(from, Axis::HORIZONTAL), node_of(from, Axis::VERTICAL)};
+        return search(sources, [to](size_t field) { return field == to; }, ALL_JUMPS);
+    }
+
+    uint32_t AxisGraph::min_heat_loss(std::span<const size_t> sources, std::span<const size_t> targets) {
+        m_expanded = 0;
+        const auto invalid = [this](size_t field) { return !valid(field); };
+        if (std::any_of(sources.begin(), sources.end(), invalid) ||
+            std::any_of(targets.begin(), targets.end(), invalid)) {
+            return UNREACHABLE;
+        }
+        std::vector<bool> is_target(m_width * m_height, false);
+        for (const auto field: targets) {
+            is_target[field] = true;
+        }
+        std::vector<uint32_t> nodes;
+        for (const auto field: sources) {
+            nodes.push_back(node_of(field, Axis::HORIZONTAL));
+            nodes.push_back(node_of(field, Axis::VERTICAL));
+        }
+        prepare_bound(0, Heuristic::NONE);
+        return search(nodes, [&](size_t field) { return is_target[field]; }, ALL_JUMPS);
+    }
+
+    std::vector<uint32_t> AxisGraph::heat_map(size_t from) {
+        const size_t fields = m_width * m_height;
+        std::vector<uint32_t> result(fields, UNREACHABLE);
+        if (!valid(from)) {
+            return result;
+        }
+        prepare_bound(0, Heuristic::NONE);
+        const uint32_t sources[] = {node_of(from, Axis::HORIZONTAL), node_of(from, Axis::VERTICAL)};
+        search(sources, [](size_t) { return false; }, ALL_JUMPS);
+        for (size_t field = 0; field < fields; ++field) {
+            result[field] = std::min(m_heat[node_of(field, Axis::HORIZONTAL)], m_heat[node_of(field, Axis::VERTICAL)]);
+        }
+        return result;
+    }
+
+    std::vector<uint32_t> AxisGraph::trace(uint32_t node) const {
+        std::vector<uint32_t> nodes;
+        for (; node != NO_NODE; node = m_parent[node]) {
+            nodes.push_back(node);
+        }
+        std::reverse(nodes.begin(), nodes.end());
+        return nodes;
+    }
+
+    uint32_t AxisGraph::jump_heat(uint32_t from, uint32_t next) const {
+        const size_t a = field_of(from);
+        const size_t b = field_of(next);
+        if (a / m_width == b / m_width) {
+            // same row, the field we leave does not count, the one we stop at does
+            const uint32_t *row = &m_row_prefix[(a / m_width) * (m_width + 1)];
+            const size_t x_a = a % m_width;
+            const size_t x_b = b % m_width;
+            return x_b > x_a ? row[x_b + 1] - row[x_a + 1] : row[x_a] - row[x_b];
+        }
+        const uint32_t *column = &m_column_prefix[(a % m_width) * (m_height + 1)];
+        const size_t y_a = a / m_width;
+        const size_t y_b = b / m_width;
+        return y_b > y_a ? column[y_b + 1] - column[y_a + 1] : column[y_a] - column[y_b];
+    }
+
+    std::optional<Route> AxisGraph::min_heat_route(size_t from, size_t to) {
+        const uint32_t heat = min_heat_loss(from, to, Heuristic::REVERSE_DIJKSTRA);
+        if (heat == UNREACHABLE) {
+            return std::nullopt;
+        }
+        Route route{.heat = heat, .stops = {}};
+        for (const auto node: trace(m_reached)) {
+            route.stops.push_back(field_of(node));
+        }
+        return route;
+    }
+
+    std::vector<Route> AxisGraph::k_min_heat_routes(size_t from, size_t to, size_t k) {
+        std::vector<Route> routes;
+        if (k == 0 || min_heat_loss(from, to, Heuristic::REVERSE_DIJKSTRA) == UNREACHABLE) {
+            return routes;
+        }
+        if (from == to) {
+            // both axes of `from` give the same (empty) route
+            routes.push_back(Route{.heat = 0, .stops = {from}});
+            return routes;
+        }
+        if (m_blocked.size() != node_count()) {
+            m_blocked.assign(node_count(), 0);
+        }
+        const auto is_target = [to](size_t field) { return field == to; };
+
+        // routes as nodes of the graph; a route can start on either axis of `from`, which we treat like a
+        // common (virtual) first node the spur at index -1 leaves from
+        std::vector<std::vector<uint32_t>> found = {trace(m_reached)};
+        std::vector<uint32_t> found_heat = {m_heat[m_reached]};
+        std::vector<std::pair<uint32_t, std::vector<uint32_t>>> candidates;
+        std::vector<uint32_t> blocked_next;
+        std::vector<uint32_t> sources;
+
+        while (found.size() < k) {
+            const std::vector<uint32_t> last = found.back();
+            uint32_t root_heat = 0;
+            for (ptrdiff_t spur = -1; spur + 1 < static_cast<ptrdiff_t>(last.size()); ++spur) {
+                const auto root_end = last.begin() + spur + 1;
+                if (spur > 0) {
+                    root_heat += jump_heat(last[spur - 1], last[spur]);
+                }
+
+                // the next node of every route we have with the same root is not an option anymore
+                blocked_next.clear();
+                for (const auto &path: found) {
+                    if (path.size() > static_cast<size_t>(spur + 1) && std::equal(last.begin(), root_end, path.begin())) {
+                        blocked_next.push_back(path[spur + 1]);
+                    }
+                }
+                // and the root must not be visited again
+                ++m_generation;
+                for (auto it = last.begin(); it + 1 < root_end; ++it) {
+                    m_blocked[*it] = m_generation;
+                }
+
+                sources.clear();
+                if (spur < 0) {
+                    for (const auto axis: {Axis::HORIZONTAL, Axis::VERTICAL}) {
+                        if (std::find(blocked_next.begin(), blocked_next.end(), node_of(from, axis)) == blocked_next.end()) {
+                            sources.push_back(node_of(from, axis));
+                        }
+                    }
+                } else {
+                    sources.push_back(last[spur]);
+                }
+                const uint32_t spur_node = spur < 0 ? NO_NODE : last[spur];
+                const uint32_t heat = search(sources, is_target, [&](uint32_t node, uint32_t next) {
+                    return m_blocked[next] != m_generation &&
+                           (node != spur_node || std::find(blocked_next.begin(), blocked_next.end(), next) == blocked_next.end());
+                });
+                if (heat == UNREACHABLE) {
+                    continue;
+                }
+
+                std::vector<uint32_t> path(last.begin(), spur < 0 ? last.begin() : root_end - 1);
+                const auto spur_path = trace(m_reached);
+                path.insert(path.end(), spur_path.begin(), spur_path.end());
+                const bool known = std::find(found.begin(), found.end(), path) != found.end() ||
+                                   std::any_of(candidates.begin(), candidates.end(), [&](const auto &candidate) {
+                                       return candidate.second == path;
+                                   });
+                if (!known) {
+                    candidates.emplace_back(root_heat + heat, std::move(path));
+                }
+            }
+            if (candidates.empty()) {
+                break;
+            }
+            const auto best = std::min_element(candidates.begin(), candidates.end(), [](const auto &a, const auto &b) {
+                return a.first < b.first;
+            });
+            found_heat.push_back(best->first);
+            found.push_back(std::move(best->second));
+            candidates.erase(best);
+        }
+
+        for (size_t i = 0; i < found.size(); ++i) {
+            Route route{.heat = found_heat[i], .stops = {}};
+            for (const auto node: found[i]) {
+                route.stops.push_back(field_of(node));
+            }
+            routes.push_back(std::move(route));
+        }
+        return routes;
+    }
+
+    std::vector<size_t> AxisGraph::fields_of(const Route &route) const {
+        std::vector<size_t> fields;
+        if (route.stops.empty()) {
+            return fields;
+        }
+        fields.push_back(route.stops.front());
+        for (size_t i = 1; i < route.stops.size(); ++i) {
+            const size_t from = route.stops[i - 1];
+            const size_t to = route.stops[i];
+            const size_t step = from / m_width == to / m_width ? 1 : m_width;
+            for (size_t field = from; field != to;) {
+                field = to > from ? field + step : field - step;
+                fields.push_back(field);
+            }
+        }
+        return fields;
+    }
+
+    size_t AxisGraph::bytes() const {
+        return (m_row_prefix.capacity() + m_column_prefix.capacity() + m_heat.capacity() + m_heat_back.capacity() +
+                m_parent.capacity() + m_blocked.capacity() + m_bound.capacity()) * sizeof(uint32_t);
+    }
+
+    uint32_t AxisGraph::min_heat_loss_bidirectional(size_t from, size_t to) {
+        m_expanded = 0;
+        if (!valid(from) || !valid(to)) {
+            return UNREACHABLE;
+        }
+        if (from == to) {
+            return 0;
+        }
+        m_heat.assign(node_count(), UNREACHABLE);
+        m_heat_back.assign(node_count(), UNREACHABLE);
+
+        BucketQueue<QueuedNode, QueuedHeat> forward(max_edge_heat());
+        BucketQueue<QueuedNode, QueuedHeat> backward(max_edge_heat());
+        for (const auto axis: {Axis::HORIZONTAL, Axis::VERTICAL}) {
+            m_heat[node_of(from, axis)] = 0;
+            forward.push({0, node_of(from, axis)});
+            m_heat_back[node_of(to, axis)] = 0;
+            backward.push({0, node_of(to, axis)});
+        }
+
+        // every relaxed node both searches reached is a way from `from` to `to`; once the cheapest heats left in
+        // the two queues add up to the best of those, no way through an unsettled node can be cheaper
+        uint32_t best = UNREACHABLE;
+        while (!forward.empty() && !backward.empty() && forward.top().heat + backward.top().heat < best) {
+            const bool go_forward = forward.top().heat <= backward.top().heat;
+            auto &queue = go_forward ? forward : backward;
+            auto &heat_of = go_forward ? m_heat : m_heat_back;
+            const auto &other = go_forward ? m_heat_back : m_heat;
+            const auto [heat, node] = queue.top();
+            queue.pop();
+            if (heat != heat_of[node]) {
+                continue;
+            }
+            ++m_expanded;
+            const auto relax = [&](uint32_t next, uint32_t jump_heat) {
+                if (heat + jump_heat < heat_of[next]) {
+                    heat_of[next] = heat + jump_heat;
+                    queue.push({heat + jump_heat, next});
+                    if (other[next] != UNREACHABLE) {
+                        best = std::min(best, heat + jump_heat + other[next]);
+                    }
+                }
+            };
+            if (go_forward) {
+                for_each_jump(node, relax);
+            } else {
+                for_each_jump_back(node, relax);
+            }
+        }
+        return best;
+    }
+}
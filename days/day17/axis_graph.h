@@ -0,0 +1,289 @@
+#ifndef AOC2024_DAY17_AXIS_GRAPH_H
+#define AOC2024_DAY17_AXIS_GRAPH_H
+
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+#include "day17.h"
+
+namespace aoc2024::day17 {
+
+    enum class Axis : uint8_t {
+        HORIZONTAL,
+        VERTICAL,
+    };
+
+    /// lower bound of the heat still to lose that [AxisGraph::min_heat_loss] orders its queue by (A*)
+    enum class Heuristic {
+        /// plain Dijkstra
+        NONE,
+
+        /// fields to go (manhattan distance) times the cheapest field
+        MANHATTAN,
+
+        /// least heat from every field to the target ignoring the straight run limits (one Dijkstra over the fields
+        /// backwards from the target, kept as long as the target stays the same)
+        REVERSE_DIJKSTRA,
+    };
+
+    /***
+     * @brief A way through the field as found by [AxisGraph]
+     */
+    struct Route {
+        uint32_t heat = 0;
+
+        /// fields the crucible stops (and turns) at, from the start to the target
+        std::vector<size_t> stops;
+    };
+
+    /***
+     * @brief Crucible moves as a graph of (field, axis) nodes where every edge is a whole straight run
+     *
+     * A node is a field we stopped on together with the axis we moved along to get there, so the next run goes
+     * along the other axis. An edge jumps min_straight..max_straight fields at once, its heat loss comes from prefix
+     * sums over the rows and columns. The straight move counter of [Field::do_steps] is gone (its state space is
+     * max_straight times larger) and so is every part 1 / part 2 special case: both are just different rules.
+     *
+     * The buffers of the searches are allocated by the first search that needs them, so a graph only used for its
+     * jumps (e.g. by [DeltaStepping]) holds nothing but the prefix sums.
+     */
+    class AxisGraph {
+    public:
+        static constexpr uint32_t UNREACHABLE = UINT32_MAX;
+        static constexpr uint32_t NO_NODE = UINT32_MAX;
+
+        AxisGraph(const Field &field, CrucibleRules rules);
+
+        [[nodiscard]] size_t width() const {
+            return m_width;
+        }
+
+        [[nodiscard]] size_t height() const {
+            return m_height;
+        }
+
+        [[nodiscard]] CrucibleRules rules() const {
+            return m_rules;
+        }
+
+        /***
+         * @brief whether the rules allow to move at all (min_straight 1..max_straight); every search of a graph with
+         *        invalid rules finds nothing
+         */
+        [[nodiscard]] bool valid_rules() const {
+            return m_rules.min_straight > 0 && m_rules.min_straight <= m_rules.max_straight;
+        }
+
+        [[nodiscard]] size_t node_count() const {
+            return m_width * m_height * 2;
+        }
+
+        [[nodiscard]] static uint32_t node_of(size_t field, Axis axis) {
+            return static_cast<uint32_t>(field * 2 + static_cast<size_t>(axis));
+        }
+
+        [[nodiscard]] static size_t field_of(uint32_t node) {
+            return node / 2;
+        }
+
+        [[nodiscard]] static Axis axis_of(uint32_t node) {
+            return static_cast<Axis>(node % 2);
+        }
+
+        /***
+         * @brief the most heat a single edge can cost
+         */
+        [[nodiscard]] size_t max_edge_heat() const {
+            return m_rules.max_straight * MAX_HEAT_LOSS;
+        }
+
+        /***
+         * @brief Calls `fn(next_node, heat_loss)` for every run we can do after arriving at `node`
+         */
+        template<typename Fn>
+        void for_each_jump(uint32_t node, Fn &&fn) const {
+            const size_t field = field_of(node);
+            const size_t x = field % m_width;
+            const size_t y = field / m_width;
+            if (axis_of(node) == Axis::VERTICAL) {
+                // turn left / right
+                const uint32_t *row = &m_row_prefix[y * (m_width + 1)];
+                for (size_t n = m_rules.min_straight; n <= m_rules.max_straight && x + n < m_width; ++n) {
+                    fn(node_of(field + n, Axis::HORIZONTAL), row[x + n + 1] - row[x + 1]);
+                }
+                for (size_t n = m_rules.min_straight; n <= m_rules.max_straight && n <= x; ++n) {
+                    fn(node_of(field - n, Axis::HORIZONTAL), row[x] - row[x - n]);
+                }
+            } else {
+                // turn up / down
+                const uint32_t *column = &m_column_prefix[x * (m_height + 1)];
+                for (size_t n = m_rules.min_straight; n <= m_rules.max_straight && y + n < m_height; ++n) {
+                    fn(node_of(field + n * m_width, Axis::VERTICAL), column[y + n + 1] - column[y + 1]);
+                }
+                for (size_t n = m_rules.min_straight; n <= m_rules.max_straight && n <= y; ++n) {
+                    fn(node_of(field - n * m_width, Axis::VERTICAL), column[y] - column[y - n]);
+                }
+            }
+        }
+
+        /***
+         * @brief Calls `fn(previous_node, heat_loss)` for every run that arrives at `node` (the jumps backwards)
+         */
+        template<typename Fn>
+        void for_each_jump_back(uint32_t node, Fn &&fn) const {
+            const size_t field = field_of(node);
+            const size_t x = field % m_width;
+            const size_t y = field / m_width;
+            if (axis_of(node) == Axis::HORIZONTAL) {
+                // came from the left / right
+                const uint32_t *row = &m_row_prefix[y * (m_width + 1)];
+                for (size_t n = m_rules.min_straight; n <= m_rules.max_straight && n <= x; ++n) {
+                    fn(node_of(field - n, Axis::VERTICAL), row[x + 1] - row[x + 1 - n]);
+                }
+                for (size_t n = m_rules.min_straight; n <= m_rules.max_straight && x + n < m_width; ++n) {
+                    fn(node_of(field + n, Axis::VERTICAL), row[x + n] - row[x]);
+                }
+            } else {
+                // came from above / below
+                const uint32_t *column = &m_column_prefix[x * (m_height + 1)];
+                for (size_t n = m_rules.min_straight; n <= m_rules.max_straight && n <= y; ++n) {
+                    fn(node_of(field - n * m_width, Axis::HORIZONTAL), column[y + 1] - column[y + 1 - n]);
+                }
+                for (size_t n = m_rules.min_straight; n <= m_rules.max_straight && y + n < m_height; ++n) {
+                    fn(node_of(field + n * m_width, Axis::HORIZONTAL), column[y + n] - column[y]);
+                }
+            }
+        }
+
+        /***
+         * @brief Least heat loss from field `from` to field `to` (the heat of `from` does not count, `to` does)
+         *
+         * The crucible may leave `from` in any direction, so both axes are seeded.
+         *
+         * @param from
+         * @param to
+         * @param heuristic A* lower bound to search with, all of them give the same result
+         * @return UNREACHABLE if the rules do not allow to stop at `to`
+         */
+        [[nodiscard]] uint32_t min_heat_loss(size_t from, size_t to, Heuristic heuristic = Heuristic::NONE);
+
+        /***
+         * @brief Least heat loss from any of the `sources` to any of the `targets` (fields, Dijkstra)
+         * @return UNREACHABLE if there is no way (or one of the sets is empty)
+         */
+        [[nodiscard]] uint32_t min_heat_loss(std::span<const size_t> sources, std::span<const size_t> targets);
+
+        /***
+         * @brief Same as [min_heat_loss] for one pair, searching from both ends until the two searches meet
+         */
+        [[nodiscard]] uint32_t min_heat_loss_bidirectional(size_t from, size_t to);
+
+        /***
+         * @brief Least heat loss from `from` to every field, UNREACHABLE where the crucible can not stop
+         * @param from
+         * @return one value per field (row by row)
+         */
+        [[nodiscard]] std::vector<uint32_t> heat_map(size_t from);
+
+        /***
+         * @brief The cheapest route from `from` to `to` (A* with the reverse Dijkstra bound)
+         * @return nullopt if there is none
+         */
+        [[nodiscard]] std::optional<Route> min_heat_route(size_t from, size_t to);
+
+        /***
+         * @brief The `k` cheapest routes from `from` to `to`, cheapest first (Yen's algorithm on the graph)
+         *
+         * Routes differ in at least one stop; fewer than `k` come back if there are no more. Every spur search
+         * shares the target, so they all run A* with the same reverse Dijkstra bound.
+         */
+        [[nodiscard]] std::vector<Route> k_min_heat_routes(size_t from, size_t to, size_t k);
+
+        /***
+         * @brief every field `route` passes, from its start to its target
+         */
+        [[nodiscard]] std::vector<size_t> fields_of(const Route &route) const;
+
+        /***
+         * @brief heat loss of the run from `from` to `next` (two nodes in the same row or column)
+         */
+        [[nodiscard]] uint32_t jump_heat(uint32_t from, uint32_t next) const;
+
+        /***
+         * @brief memory the graph and its search state take right now
+         */
+        [[nodiscard]] size_t bytes() const;
+
+        /***
+         * @brief nodes the last search expanded (took out of the queue to follow their jumps)
+         */
+        [[nodiscard]] size_t last_expanded() const {
+            return m_expanded;
+        }
+
+    private:
+        [[nodiscard]] uint32_t heat_at(size_t field) const {
+            const size_t x = field % m_width;
+            const uint32_t *row = &m_row_prefix[(field / m_width) * (m_width + 1)];
+            return row[x + 1] - row[x];
+        }
+
+        /***
+         * @brief fills m_bound for `to` unless it already is
+         */
+        void prepare_bound(size_t to, Heuristic heuristic);
+
+        /***
+         * @brief (A*) search from the `sources` (nodes) until a node with `is_target(field)` comes out of the queue
+         *
+         * Only jumps with `allowed(node, next)` are followed. m_heat and m_parent have the heat and the previous
+         * node of every node reached, m_reached the target node found.
+         *
+         * @return its heat or UNREACHABLE
+         */
+        template<typename IsTarget, typename Allowed>
+        uint32_t search(std::span<const uint32_t> sources, IsTarget &&is_target, Allowed &&allowed);
+
+        /***
+         * @brief the nodes from a source of the last search to `node`
+         */
+        [[nodiscard]] std::vector<uint32_t> trace(uint32_t node) const;
+
+        [[nodiscard]] bool valid(size_t field) const {
+            return field < m_width * m_height && valid_rules();
+        }
+
+        size_t m_width;
+        size_t m_height;
+        CrucibleRules m_rules;
+
+        /// m_row_prefix[y * (width + 1) + x] = heat of the fields left of x in row y
+        std::vector<uint32_t> m_row_prefix;
+
+        /// m_column_prefix[x * (height + 1) + y] = heat of the fields above y in column x
+        std::vector<uint32_t> m_column_prefix;
+
+        /// heat loss per node of the last search
+        std::vector<uint32_t> m_heat;
+
+        /// node every node was reached from in the last search (NO_NODE for the sources)
+        std::vector<uint32_t> m_parent;
+        uint32_t m_reached = NO_NODE;
+
+        /// nodes a spur search of [k_min_heat_routes] must not use are marked with the current generation
+        std::vector<uint32_t> m_blocked;
+        uint32_t m_generation = 0;
+
+        /// heat loss from every node to the target of the last bidirectional search
+        std::vector<uint32_t> m_heat_back;
+        size_t m_expanded = 0;
+
+        /// lower bound of the heat from every field to m_bound_target
+        std::vector<uint32_t> m_bound;
+        size_t m_bound_target = SIZE_MAX;
+        Heuristic m_bound_heuristic = Heuristic::NONE;
+    };
+}
+
+#endif //AOC2024_DAY17_AXIS_GRAPH_H
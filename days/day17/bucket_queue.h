@@ -0,0 +1,76 @@
+#ifndef AOC2024_DAY17_BUCKET_QUEUE_H
+#define AOC2024_DAY17_BUCKET_QUEUE_H
+
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace aoc2024::day17 {
+
+    /***
+     * @brief Monotone priority queue over small integer keys (Dial's algorithm)
+     *
+     * Keeps `max_step + 1` buckets in a ring, a value with key k lives in bucket k % (max_step + 1). This only works
+     * if every pushed key is between the last key popped and that key + `max_step` - which is the case for
+     * shortest paths where no edge costs more than `max_step`. Push and pop are O(1) (pop amortized over the empty
+     * buckets it skips); values with the same key come out in no particular order.
+     *
+     * Same interface as the `std::priority_queue` used as reference (`push`, `top`, `pop`, `empty`).
+     *
+     * @tparam T value type
+     * @tparam Key functor returning the (integer) key of a value
+     */
+    template<typename T, typename Key>
+    class BucketQueue {
+    public:
+        explicit BucketQueue(std::size_t max_step, Key key = {}) : m_buckets(max_step + 1), m_key(key) {
+        }
+
+        [[nodiscard]] bool empty() const {
+            return m_size == 0;
+        }
+
+        [[nodiscard]] std::size_t size() const {
+            return m_size;
+        }
+
+        void push(T value) {
+            const std::size_t key = m_key(value);
+            // the smallest key so far (a node's children come in any order, the queue may have run empty in between)
+            if (m_size == 0 || key < m_current) {
+                m_current = key;
+            }
+            m_buckets[key % m_buckets.size()].push_back(std::move(value));
+            ++m_size;
+        }
+
+        /***
+         * @brief one of the values with the smallest key (queue must not be empty)
+         */
+        const T &top() {
+            settle();
+            return m_buckets[m_current % m_buckets.size()].back();
+        }
+
+        void pop() {
+            settle();
+            m_buckets[m_current % m_buckets.size()].pop_back();
+            --m_size;
+        }
+
+    private:
+        /// moves on to the first bucket that has something in it
+        void settle() {
+            while (m_buckets[m_current % m_buckets.size()].empty()) {
+                ++m_current;
+            }
+        }
+
+        std::vector<std::vector<T>> m_buckets;
+        Key m_key;
+        std::size_t m_current = 0;
+        std::size_t m_size = 0;
+    };
+}
+
+#endif //AOC2024_DAY17_BUCKET_QUEUE_H
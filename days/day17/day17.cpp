@@ -2,14 +2,23 @@
 // Created by Richard Vogel on 17.12.23.
 //
 #include "day17.h"
+#include "axis_graph.h"
 #include <iostream>
 #include <list>
-#include <queue>
 
 namespace aoc2024::day17 {
 
 
     Field Field::parse(const std::vector<std::string> &input) {
+        return parse_lines(input);
+    }
+
+    Field Field::parse(std::span<const std::string_view> input) {
+        return parse_lines(input);
+    }
+
+    template<typename Lines>
+    Field Field::parse_lines(const Lines &input) {
         Field field;
         if (input.empty()) {
             std::cerr << "Input is empty" << std::endl;
@@ -50,149 +59,65 @@ namespace aoc2024::day17 {
         return result;
     }
 
-    std::size_t Field::do_steps(PathDescriptor start, bool second_task) {
-        std::priority_queue<PathDescriptor, std::vector<PathDescriptor>, ComparePath> path = {};
-        path.push(std::move(start));
-        std::size_t global_min = -1;
-
-        while (!path.empty()) {
-            const PathDescriptor curr = path.top();
-            path.pop();
-            const auto x = curr.x;
-            const auto y = curr.y;
-
-            if (x >= width() || y >= height()) {
-                continue; // out of bounds
-            }
-
-            auto &field = get_mut(x, y);
-            const auto accumulated_heat = curr.accumulated_heat + field.heat_loss;
-
-            if (accumulated_heat >= global_min) {
-                continue;
-            }
-
-            // end condition
-            if (x == width() - 1 && y == height() - 1) {
-                // std::cout << accumulated_heat << std::endl;
-                if (accumulated_heat < global_min) {
-                    if (!second_task) {
-                        // always valid if we touch the end
-                        global_min = accumulated_heat;
-                    } else {
-                        // only valid if we made at least 4 straight moves
-                        if (curr.straight_move_count >= 3) {
-                            global_min = accumulated_heat;
-                        }
-                    }
-                }
-                continue;
-            }
-
-            auto &visited_state_dir = field.visited_state.at(curr.dir);
-            if (!visited_state_dir.contains(curr.straight_move_count)) {
-                visited_state_dir[curr.straight_move_count] = accumulated_heat;
-            } else {
-                if (visited_state_dir[curr.straight_move_count] <= accumulated_heat) {
-                    continue;
-                }
-                visited_state_dir[curr.straight_move_count] = accumulated_heat;
-            }
+    std::size_t Field::do_steps(PathDescriptor start, bool second_task, QueueKind queue) {
+        return second_task ? do_steps<4, 10>(start, queue) : do_steps<1, 3>(start, queue);
+    }
 
-            if (!second_task) {
-                for (const auto next_dir: possible_moves.at(curr.dir)) {
-                    const auto next_pos = std::pair{x + dx_dy.at(next_dir).first, y + dx_dy.at(next_dir).second};
-                    if (next_dir == curr.dir) {
-                        // we can go straight
-                        if (curr.straight_move_count < 3) {
-                            path.push({
-                                              .x=next_pos.first,
-                                              .y=next_pos.second,
-                                              .straight_move_count=static_cast<used_straight_moves_t>(
-                                                      curr.straight_move_count + 1),
-                                              .dir=next_dir,
-                                              .accumulated_heat=accumulated_heat,
-                                      });
-                        }
-                    } else {
-                        // we can go 90 degrees
-                        path.push({.x=next_pos.first,
-                                          .y=next_pos.second,
-                                          .straight_move_count=1, .dir=next_dir, .accumulated_heat=accumulated_heat,
-                                  });
-                    }
-                }
-            } else {
-                // second task
-                const auto straight_move_cnt = curr.straight_move_count;
-                if (straight_move_cnt < 4) {
-                    // we must go straight
-                    const auto next_pos = std::pair{x + dx_dy.at(curr.dir).first, y + dx_dy.at(curr.dir).second};
-                    path.push({
-                                      .x=next_pos.first,
-                                      .y=next_pos.second,
-                                      .straight_move_count=static_cast<used_straight_moves_t>(
-                                              curr.straight_move_count + 1),
-                                      .dir=curr.dir,
-                                      .accumulated_heat=accumulated_heat,
-                              });
-                } else {
-                    // we can go 90 degrees
-                    for (const auto next_dir: possible_moves.at(curr.dir)) {
-                        const bool is_straight_move = next_dir == curr.dir;
-                        if (is_straight_move) {
-                            if (curr.straight_move_count > 9) { // we **must** turn here
-                                continue;
-                            }
-                        }
+    std::size_t Field::do_steps(PathDescriptor start, CrucibleRules rules, QueueKind queue, MoveTable moves) {
+        if (rules.min_straight == 1 && rules.max_straight == 3) {
+            return do_steps<1, 3>(start, queue, moves);
+        }
+        if (rules.min_straight == 4 && rules.max_straight == 10) {
+            return do_steps<4, 10>(start, queue, moves);
+        }
+        if (rules.min_straight == 2 && rules.max_straight == 7) {
+            return do_steps<2, 7>(start, queue, moves);
+        }
+        return do_steps_generic(start, rules, queue, moves);
+    }
 
-                        const auto next_pos = std::pair{x + dx_dy.at(next_dir).first, y + dx_dy.at(next_dir).second};
-                        path.push({.x=next_pos.first,
-                                          .y=next_pos.second,
-                                          .straight_move_count=!is_straight_move
-                                                               ? static_cast<used_straight_moves_t>(1)
-                                                               : static_cast<used_straight_moves_t>(
-                                                                       curr.straight_move_count +
-                                                                       1),
-                                          .dir=next_dir,
-                                          .accumulated_heat=accumulated_heat,
-                                  });
-                    }
-                }
-            }
+    std::size_t Field::do_steps_generic(PathDescriptor start, CrucibleRules rules, QueueKind queue,
+                                        MoveTable moves) {
+        if (rules.min_straight == 0 || rules.min_straight > rules.max_straight || rules.max_straight > UINT8_MAX) {
+            std::cerr << "Invalid crucible rules " << rules.min_straight << ".." << rules.max_straight << std::endl;
+            return -1;
         }
+        if (moves == MoveTable::MAP) {
+            return search<MapMoves>(start, rules, queue);
+        }
+        return search<ArrayMoves>(start, rules, queue);
+    }
 
+    std::optional<std::size_t> Field::min_heat_loss(std::span<const std::size_t> sources,
+                                                    std::span<const std::size_t> targets,
+                                                    CrucibleRules rules) const {
+        AxisGraph graph(*this, rules);
+        const auto heat = graph.min_heat_loss(sources, targets);
+        return heat == AxisGraph::UNREACHABLE ? std::nullopt : std::optional<std::size_t>(heat);
+    }
 
-        return global_min;
+    std::optional<std::size_t> Field::min_heat_loss_bidirectional(std::size_t from, std::size_t to,
+                                                                  CrucibleRules rules) const {
+        AxisGraph graph(*this, rules);
+        const auto heat = graph.min_heat_loss_bidirectional(from, to);
+        return heat == AxisGraph::UNREACHABLE ? std::nullopt : std::optional<std::size_t>(heat);
     }
 
-    int day17_1(const std::vector<std::string> &input) {
-        Field f = Field::parse(input);
-        // std::cout << f.to_string() << std::endl;
-        auto res = f.do_steps({
-                                      .x=0,
-                                      .y=0,
-                                      .straight_move_count=0,
-                                      .dir=Direction::RIGHT,
-                                      .accumulated_heat=0,
-                              });
+    std::vector<uint32_t> Field::heat_map(std::size_t from, CrucibleRules rules) const {
+        AxisGraph graph(*this, rules);
+        return graph.heat_map(from);
+    }
 
-        return static_cast<int>(res) - f.get(0, 0).heat_loss; // correct for the first step
+    int day17_1(const std::vector<std::string> &input) {
+        const Field f = Field::parse(input);
+        AxisGraph graph(f, CRUCIBLE);
+        return static_cast<int>(graph.min_heat_loss(0, f.width() * f.height() - 1));
     }
 
     int day17_2(const std::vector<std::string> &input) {
-        Field f = Field::parse(input);
-        // std::cout << f.to_string() << std::endl;
-        auto res = f.do_steps({
-                                      .x=0,
-                                      .y=0,
-                                      .straight_move_count=0,
-                                      .dir=Direction::DOWN, // idk why I need to start with down (all examples work with right; however, the task does not state that we need to start with right)
-                                      .accumulated_heat=0,
-                              }, true);
-
-        return static_cast<int>(res) - f.get(0, 0).heat_loss;
+        const Field f = Field::parse(input);
+        // both axes are seeded, so it does not matter whether we start going right or down
+        AxisGraph graph(f, ULTRA_CRUCIBLE);
+        return static_cast<int>(graph.min_heat_loss(0, f.width() * f.height() - 1));
     }
-
-
 }
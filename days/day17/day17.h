@@ -7,8 +7,18 @@
 
 #include <string>
 #include <ranges>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <iostream>
 #include <map>
 #include <ostream>
+#include <optional>
+#include <queue>
+#include <span>
+#include <string_view>
+#include <vector>
+#include "bucket_queue.h"
 
 namespace aoc2024::day17 {
     using used_straight_moves_t = uint8_t;
@@ -36,6 +46,112 @@ namespace aoc2024::day17 {
         }
     };
 
+    /// key of a path in a [BucketQueue]
+    struct PathHeat {
+        std::size_t operator()(const PathDescriptor &path) const {
+            return path.accumulated_heat;
+        }
+    };
+
+    /// the most a single cell can cost (one digit)
+    constexpr std::size_t MAX_HEAT_LOSS = 9;
+
+    /// how many fields a crucible moves in one direction before it has to (and may) turn
+    struct CrucibleRules {
+        std::size_t min_straight;
+        std::size_t max_straight;
+    };
+
+    constexpr CrucibleRules CRUCIBLE{.min_straight = 1, .max_straight = 3};
+    constexpr CrucibleRules ULTRA_CRUCIBLE{.min_straight = 4, .max_straight = 10};
+
+    /***
+     * @brief [CrucibleRules] known at compile time, so [Field::do_steps] can be specialized for them
+     */
+    template<std::size_t MinStraight, std::size_t MaxStraight>
+    struct StaticRules {
+        static_assert(MinStraight >= 1 && MinStraight <= MaxStraight && MaxStraight <= UINT8_MAX);
+
+        static constexpr std::size_t min_straight = MinStraight;
+        static constexpr std::size_t max_straight = MaxStraight;
+    };
+
+    /// priority queue [Field::do_steps] works with
+    enum class QueueKind {
+        /// `std::priority_queue`, O(log n) per push / pop (reference)
+        BINARY_HEAP,
+
+        /// [BucketQueue] with MAX_HEAT_LOSS + 1 buckets, O(1) per push / pop
+        BUCKETS,
+
+        /// `std::priority_queue` of [PackedPath]s (8 instead of 32 bytes, compared as one integer)
+        PACKED_HEAP,
+
+        /// [BucketQueue] of [PackedPath]s
+        PACKED_BUCKETS,
+    };
+
+    /***
+     * @brief A [PathDescriptor] in 8 bytes: heat (26 bits) | y (16) | x (16) | direction (2) | straight moves (4)
+     *
+     * The heat is in the high bits, so ordering two paths is a single compare of the words shifted down. Every part
+     * comes out with a shift and a mask (x and y are kept apart rather than as one field index, splitting that again
+     * would cost a division per path).
+     */
+    struct PackedPath {
+        static constexpr unsigned MOVE_BITS = 4;
+        static constexpr unsigned DIRECTION_BITS = 2;
+        static constexpr unsigned COORDINATE_BITS = 16;
+        static constexpr unsigned X_SHIFT = MOVE_BITS + DIRECTION_BITS;
+        static constexpr unsigned Y_SHIFT = X_SHIFT + COORDINATE_BITS;
+        static constexpr unsigned HEAT_SHIFT = Y_SHIFT + COORDINATE_BITS;
+
+        static constexpr std::size_t MAX_STRAIGHT = (std::size_t{1} << MOVE_BITS) - 1;
+        static constexpr std::size_t MAX_COORDINATE = (std::size_t{1} << COORDINATE_BITS) - 1;
+        static constexpr std::size_t MAX_HEAT = (std::size_t{1} << (64 - HEAT_SHIFT)) - 1;
+
+        static uint64_t pack(std::size_t heat, std::size_t x, std::size_t y, Direction dir,
+                             used_straight_moves_t straight_moves) {
+            return static_cast<uint64_t>(heat) << HEAT_SHIFT | static_cast<uint64_t>(y) << Y_SHIFT |
+                   static_cast<uint64_t>(x) << X_SHIFT | static_cast<uint64_t>(dir) << MOVE_BITS | straight_moves;
+        }
+
+        static std::size_t heat(uint64_t path) {
+            return path >> HEAT_SHIFT;
+        }
+
+        static std::size_t x(uint64_t path) {
+            return (path >> X_SHIFT) & MAX_COORDINATE;
+        }
+
+        static std::size_t y(uint64_t path) {
+            return (path >> Y_SHIFT) & MAX_COORDINATE;
+        }
+
+        static Direction direction(uint64_t path) {
+            return static_cast<Direction>((path >> MOVE_BITS) & 3);
+        }
+
+        static used_straight_moves_t straight_moves(uint64_t path) {
+            return static_cast<used_straight_moves_t>(path & MAX_STRAIGHT);
+        }
+    };
+
+    /// key of a packed path in a [BucketQueue]
+    struct PackedHeat {
+        std::size_t operator()(uint64_t path) const {
+            return PackedPath::heat(path);
+        }
+    };
+
+    struct ComparePackedPath {
+        /// only the heat counts: ordering paths of equal heat by their state as well makes the heap ~10% slower than the
+        /// PathDescriptor one instead of faster
+        bool operator()(uint64_t a, uint64_t b) const {
+            return PackedPath::heat(a) > PackedPath::heat(b);
+        }
+    };
+
     const std::map<Direction, std::vector<Direction>> possible_moves = {
             {Direction::UP,    {Direction::UP,   Direction::LEFT, Direction::RIGHT}},
             {Direction::DOWN,  {Direction::DOWN, Direction::LEFT, Direction::RIGHT}},
@@ -50,37 +166,120 @@ namespace aoc2024::day17 {
             {Direction::RIGHT, {1,  0}},
     };
 
+    /// next directions per [Direction] (straight on, or a turn), indexed by the direction
+    constexpr std::array<std::array<Direction, 3>, 4> NEXT_DIRECTIONS = {{
+            {Direction::UP,   Direction::LEFT, Direction::RIGHT},
+            {Direction::DOWN, Direction::LEFT, Direction::RIGHT},
+            {Direction::UP,   Direction::DOWN, Direction::LEFT},
+            {Direction::UP,   Direction::DOWN, Direction::RIGHT},
+    }};
+
+    /// one step per [Direction] as (dx, dy), indexed by the direction (-1 wraps around like in `dx_dy`)
+    constexpr std::array<std::pair<std::size_t, std::size_t>, 4> DIRECTION_STEPS = {{
+            {0,                            static_cast<std::size_t>(-1)},
+            {0,                            1},
+            {static_cast<std::size_t>(-1), 0},
+            {1,                            0},
+    }};
+
+    /// how [Field::do_steps] looks up the moves out of a state
+    enum class MoveTable {
+        /// `possible_moves` / `dx_dy`, a tree walk per lookup (reference)
+        MAP,
+
+        /// `NEXT_DIRECTIONS` / `DIRECTION_STEPS`, one indexed load
+        ARRAY,
+    };
+
+    struct MapMoves {
+        static const std::vector<Direction> &next(Direction dir) {
+            return possible_moves.at(dir);
+        }
+
+        static const std::pair<std::size_t, std::size_t> &step(Direction dir) {
+            return dx_dy.at(dir);
+        }
+    };
+
+    struct ArrayMoves {
+        static constexpr const std::array<Direction, 3> &next(Direction dir) {
+            return NEXT_DIRECTIONS[static_cast<std::size_t>(dir)];
+        }
+
+        static constexpr const std::pair<std::size_t, std::size_t> &step(Direction dir) {
+            return DIRECTION_STEPS[static_cast<std::size_t>(dir)];
+        }
+    };
+
     struct FieldType {
         /// how much we loose when touching this field
         uint8_t heat_loss;
+    };
+
+    /***
+     * @brief Lowest heat we touched a field with, per (field, direction, straight moves) in one flat array
+     *
+     * Sized for the longest straight run the rules allow, the search only reads and writes it.
+     */
+    class VisitedStates {
+    public:
+        static constexpr uint32_t UNVISITED = UINT32_MAX;
+
+        void init(size_t fields, used_straight_moves_t max_straight) {
+            m_slots = max_straight + 1;
+            m_heat.assign(fields * 4 * m_slots, UNVISITED);
+        }
+
+        void clear() {
+            std::fill(m_heat.begin(), m_heat.end(), UNVISITED);
+        }
+
+        /***
+         * @brief the most straight moves a state may have (nothing allocated yet if 0)
+         */
+        [[nodiscard]] size_t max_straight() const {
+            return m_slots == 0 ? 0 : m_slots - 1;
+        }
 
-        /// Stores how much heat we accumulated so far when touching this field under a certain direction
-        std::map<Direction,
-                std::map<used_straight_moves_t ,
-                        accumulated_heat_loss_t>> visited_state;
+        [[nodiscard]] size_t bytes() const {
+            return m_heat.size() * sizeof(uint32_t);
+        }
+
+        uint32_t &at(size_t field, Direction dir, used_straight_moves_t straight_move_count) {
+            return m_heat[(field * 4 + static_cast<size_t>(dir)) * m_slots + straight_move_count];
+        }
+
+    private:
+        size_t m_slots = 0;
+        std::vector<uint32_t> m_heat;
     };
 
     class Field {
     public:
         static Field parse(const std::vector<std::string> &input);
 
+        /***
+         * @brief Parses a field from lines which are views into a bigger buffer (e.g. [utils::MappedLines])
+         */
+        static Field parse(std::span<const std::string_view> input);
+
         void init_field(size_t width, size_t height) {
             m_width = width;
             m_height = height;
             m_field = std::vector<FieldType>(width * height);
             std::fill(m_field.begin(), m_field.end(), FieldType{});
-            reset();
+            m_visited = VisitedStates{};
         }
 
+        /***
+         * @brief Forgets the visited states of the last [do_steps]
+         */
         void reset() {
-            for (auto &f: m_field) {
-                f.visited_state = {
-                        {Direction::UP,    {}},
-                        {Direction::DOWN,  {}},
-                        {Direction::LEFT,  {}},
-                        {Direction::RIGHT, {}},
-                };
-            }
+            m_visited.clear();
+        }
+
+        [[nodiscard]] const VisitedStates &visited() const {
+            return m_visited;
         }
 
         [[nodiscard]] size_t width() const {
@@ -106,14 +305,257 @@ namespace aoc2024::day17 {
         std::string to_string() const;
 
 
-        [[nodiscard]] std::size_t do_steps(PathDescriptor start, bool second_task=false);
+        /***
+         * @brief Cheapest heat loss from `start` to the bottom right cell (including the heat of `start`)
+         *
+         * A path with `straight_move_count` 0 did not move yet and may leave in any direction but backwards.
+         *
+         * @param start
+         * @param second_task use the ultra crucible rules (4 to 10 straight moves) instead of 1 to 3
+         * @param queue which priority queue to use, both give the same result
+         * @return
+         */
+        [[nodiscard]] std::size_t do_steps(PathDescriptor start, bool second_task=false,
+                                           QueueKind queue=QueueKind::BUCKETS);
+
+        /***
+         * @brief Same as above for any rules; the ones we use often have a specialized search, all others run
+         *        [do_steps_generic]
+         * @return SIZE_MAX (and a message on stderr) for rules that make no sense
+         */
+        [[nodiscard]] std::size_t do_steps(PathDescriptor start, CrucibleRules rules,
+                                           QueueKind queue=QueueKind::BUCKETS, MoveTable moves=MoveTable::ARRAY);
+
+        /***
+         * @brief Search specialized for rules known at compile time
+         */
+        template<std::size_t MinStraight, std::size_t MaxStraight>
+        [[nodiscard]] std::size_t do_steps(PathDescriptor start, QueueKind queue=QueueKind::BUCKETS,
+                                           MoveTable moves=MoveTable::ARRAY) {
+            if (moves == MoveTable::MAP) {
+                return search<MapMoves>(start, StaticRules<MinStraight, MaxStraight>{}, queue);
+            }
+            return search<ArrayMoves>(start, StaticRules<MinStraight, MaxStraight>{}, queue);
+        }
+
+        /***
+         * @brief Search that reads the rules at run time (what [do_steps] falls back to)
+         */
+        [[nodiscard]] std::size_t do_steps_generic(PathDescriptor start, CrucibleRules rules,
+                                                   QueueKind queue=QueueKind::BUCKETS,
+                                                   MoveTable moves=MoveTable::ARRAY);
+
+        /***
+         * @brief states (field, direction, straight moves) the last [do_steps] expanded (followed the moves of)
+         */
+        [[nodiscard]] std::size_t last_expanded() const {
+            return m_expanded;
+        }
+
+        /***
+         * @brief Least heat loss from any of the `sources` to any of the `targets` (fields as y * width + x, the
+         *        heat of the source does not count)
+         *
+         * Searches the [AxisGraph] of the field; keep one of those around to run many searches on the same field.
+         *
+         * @return nullopt if there is no way
+         */
+        [[nodiscard]] std::optional<std::size_t> min_heat_loss(std::span<const std::size_t> sources,
+                                                               std::span<const std::size_t> targets,
+                                                               CrucibleRules rules) const;
+
+        /***
+         * @brief Same as above for a single pair, searching from both ends
+         */
+        [[nodiscard]] std::optional<std::size_t> min_heat_loss_bidirectional(std::size_t from, std::size_t to,
+                                                                             CrucibleRules rules) const;
+
+        /***
+         * @brief Least heat loss from `from` to every field, UINT32_MAX where the crucible can not stop
+         */
+        [[nodiscard]] std::vector<uint32_t> heat_map(std::size_t from, CrucibleRules rules) const;
 
     private:
+        /***
+         * @brief [parse] for any container of lines
+         */
+        template<typename Lines>
+        static Field parse_lines(const Lines &input);
+
+        /***
+         * @tparam Moves [MapMoves] or [ArrayMoves]
+         */
+        template<typename Moves, typename Rules>
+        std::size_t search(PathDescriptor start, Rules rules, QueueKind queue);
+
+        template<typename Moves, typename Rules, typename Queue>
+        std::size_t search(Queue &path, PathDescriptor start, Rules rules);
+
+        /***
+         * @brief Same as [search] on [PackedPath]s
+         */
+        template<typename Moves, typename Rules, typename Queue>
+        std::size_t search_packed(Queue &path, PathDescriptor start, Rules rules);
+
         std::size_t m_width;
         std::size_t m_height;
         std::vector<FieldType> m_field;
+        VisitedStates m_visited;
+        std::size_t m_expanded = 0;
     };
 
+    template<typename Moves, typename Rules>
+    std::size_t Field::search(PathDescriptor start, Rules rules, QueueKind queue) {
+        if (m_visited.max_straight() < rules.max_straight) {
+            m_visited.init(m_field.size(), static_cast<used_straight_moves_t>(rules.max_straight));
+        }
+        m_expanded = 0;
+        switch (queue) {
+            case QueueKind::BINARY_HEAP: {
+                std::priority_queue<PathDescriptor, std::vector<PathDescriptor>, ComparePath> path = {};
+                return search<Moves>(path, start, rules);
+            }
+            case QueueKind::BUCKETS: {
+                // a path is pushed with the heat of the path it came from plus one cell
+                BucketQueue<PathDescriptor, PathHeat> path(MAX_HEAT_LOSS);
+                return search<Moves>(path, start, rules);
+            }
+            case QueueKind::PACKED_HEAP: {
+                std::priority_queue<uint64_t, std::vector<uint64_t>, ComparePackedPath> path = {};
+                return search_packed<Moves>(path, start, rules);
+            }
+            case QueueKind::PACKED_BUCKETS: {
+                BucketQueue<uint64_t, PackedHeat> path(MAX_HEAT_LOSS);
+                return search_packed<Moves>(path, start, rules);
+            }
+        }
+        return -1;
+    }
+
+    template<typename Moves, typename Rules, typename Queue>
+    std::size_t Field::search(Queue &path, PathDescriptor start, Rules rules) {
+        path.push(std::move(start));
+        std::size_t global_min = -1;
+
+        while (!path.empty()) {
+            const PathDescriptor curr = path.top();
+            path.pop();
+            const auto x = curr.x;
+            const auto y = curr.y;
+
+            if (x >= width() || y >= height()) {
+                continue; // out of bounds
+            }
+
+            const auto &field = m_field[y * width() + x];
+            const auto accumulated_heat = curr.accumulated_heat + field.heat_loss;
+
+            if (accumulated_heat >= global_min) {
+                continue;
+            }
+
+            // end condition, only valid if we may stop here
+            if (x == width() - 1 && y == height() - 1) {
+                if (curr.straight_move_count >= rules.min_straight) {
+                    global_min = accumulated_heat;
+                }
+                continue;
+            }
+
+            auto &visited_heat = m_visited.at(y * width() + x, curr.dir, curr.straight_move_count);
+            if (visited_heat <= accumulated_heat) {
+                continue;
+            }
+            visited_heat = static_cast<uint32_t>(accumulated_heat);
+            ++m_expanded;
+
+            const auto straight_moves = curr.straight_move_count;
+            for (const auto next_dir: Moves::next(curr.dir)) {
+                // at the start (no moves yet) every direction counts as turning
+                const bool straight = next_dir == curr.dir && straight_moves > 0;
+                if (straight ? straight_moves >= rules.max_straight
+                             : straight_moves > 0 && straight_moves < rules.min_straight) {
+                    continue;
+                }
+                const auto &[dx, dy] = Moves::step(next_dir);
+                path.push({.x=x + dx,
+                                  .y=y + dy,
+                                  .straight_move_count=static_cast<used_straight_moves_t>(
+                                          straight ? straight_moves + 1 : 1),
+                                  .dir=next_dir,
+                                  .accumulated_heat=accumulated_heat,
+                          });
+            }
+        }
+
+        return global_min;
+    }
+
+    template<typename Moves, typename Rules, typename Queue>
+    std::size_t Field::search_packed(Queue &path, PathDescriptor start, Rules rules) {
+        if (start.x >= width() || start.y >= height()) {
+            return -1;
+        }
+        if (width() > PackedPath::MAX_COORDINATE || height() > PackedPath::MAX_COORDINATE ||
+            rules.max_straight > PackedPath::MAX_STRAIGHT) {
+            std::cerr << "Field or rules too large for packed paths, use a queue of PathDescriptors" << std::endl;
+            return -1;
+        }
+        path.push(PackedPath::pack(start.accumulated_heat, start.x, start.y, start.dir, start.straight_move_count));
+        std::size_t global_min = -1;
+
+        while (!path.empty()) {
+            const uint64_t curr = path.top();
+            path.pop();
+            const std::size_t x = PackedPath::x(curr);
+            const std::size_t y = PackedPath::y(curr);
+            const auto accumulated_heat = PackedPath::heat(curr) + m_field[y * width() + x].heat_loss;
+
+            if (accumulated_heat >= global_min) {
+                continue;
+            }
+
+            const auto straight_moves = PackedPath::straight_moves(curr);
+            if (x == width() - 1 && y == height() - 1) {
+                if (straight_moves >= rules.min_straight) {
+                    global_min = accumulated_heat;
+                }
+                continue;
+            }
+
+            const auto dir = PackedPath::direction(curr);
+            auto &visited_heat = m_visited.at(y * width() + x, dir, straight_moves);
+            if (visited_heat <= accumulated_heat) {
+                continue;
+            }
+            visited_heat = static_cast<uint32_t>(accumulated_heat);
+            if (accumulated_heat > PackedPath::MAX_HEAT) {
+                std::cerr << "Heat loss too large for packed paths, use a queue of PathDescriptors" << std::endl;
+                return -1;
+            }
+            ++m_expanded;
+
+            for (const auto next_dir: Moves::next(dir)) {
+                const bool straight = next_dir == dir && straight_moves > 0;
+                if (straight ? straight_moves >= rules.max_straight
+                             : straight_moves > 0 && straight_moves < rules.min_straight) {
+                    continue;
+                }
+                // out of bounds wraps around to a huge value, those are dropped before packing
+                const auto &[dx, dy] = Moves::step(next_dir);
+                const std::size_t next_x = x + dx;
+                const std::size_t next_y = y + dy;
+                if (next_x >= width() || next_y >= height()) {
+                    continue;
+                }
+                path.push(PackedPath::pack(accumulated_heat, next_x, next_y, next_dir,
+                                           static_cast<used_straight_moves_t>(straight ? straight_moves + 1 : 1)));
+            }
+        }
+
+        return global_min;
+    }
+
     int day17_1(const std::vector<std::string> &input);
 
     int day17_2(const std::vector<std::string> &input);
@@ -0,0 +1,177 @@
+#include "delta_stepping.h"
+#include <algorithm>
+
+namespace aoc2024::day17 {
+    namespace {
+        /// frontiers smaller than this are relaxed by the calling thread alone (waking the pool costs more)
+        constexpr size_t MIN_PARALLEL_NODES = 512;
+
+        constexpr size_t GRAIN = 256;
+
+        /***
+         * @brief lowers `heat` to `value` unless it is lower already
+         * @return whether we lowered it
+         */
+        bool atomic_min(std::atomic<uint32_t> &heat, uint32_t value) {
+            uint32_t current = heat.load(std::memory_order_relaxed);
+            while (value < current) {
+                if (heat.compare_exchange_weak(current, value, std::memory_order_relaxed)) {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+
+    DeltaStepping::DeltaStepping(const AxisGraph &graph, utils::ThreadPool &pool, uint32_t delta)
+            : m_graph(graph), m_pool(pool),
+              m_delta(delta > 0 ? delta : static_cast<uint32_t>(MAX_HEAT_LOSS * graph.rules().min_straight)),
+              m_heat(std::make_unique<std::atomic<uint32_t>[]>(graph.node_count())),
+              m_buckets(graph.max_edge_heat() / std::max<uint32_t>(m_delta, 1) + 2),
+              m_lowered(pool.size()),
+              m_stamp(graph.node_count(), 0) {
+        m_delta = std::max<uint32_t>(m_delta, 1);
+    }
+
+    void DeltaStepping::relax(const std::vector<uint32_t> &nodes, bool light) {
+        ++m_rounds;
+        const auto relax_range = [&](size_t begin, size_t end, size_t worker) {
+            auto &lowered = m_lowered[worker];
+            for (size_t i = begin; i < end; ++i) {
+                const uint32_t node = nodes[i];
+                const uint32_t heat = m_heat[node].load(std::memory_order_relaxed);
+                m_graph.for_each_jump(node, [&](uint32_t next, uint32_t jump_heat) {
+                    if ((jump_heat <= m_delta) == light && atomic_min(m_heat[next], heat + jump_heat)) {
+                        lowered.push_back(next);
+                    }
+                });
+            }
+        };
+        if (nodes.size() < MIN_PARALLEL_NODES || m_pool.size() == 1) {
+            relax_range(0, nodes.size(), 0);
+        } else {
+            m_pool.parallel_for(nodes.size(), GRAIN, relax_range);
+        }
+    }
+
+    uint16_t DeltaStepping::next_round() {
+        if (++m_round == 0) {
+            std::fill(m_stamp.begin(), m_stamp.end(), 0);
+            m_round = 1;
+        }
+        return m_round;
+    }
+
+    void DeltaStepping::collect() {
+        const uint16_t round = next_round();
+        for (auto &lowered: m_lowered) {
+            for (const auto node: lowered) {
+                if (m_stamp[node] == round) {
+                    continue;
+                }
+                m_stamp[node] = round;
+                const uint32_t bucket = m_heat[node].load(std::memory_order_relaxed) / m_delta;
+                m_buckets[bucket % m_buckets.size()].push_back(node);
+                ++m_queued;
+            }
+            lowered.clear();
+        }
+    }
+
+    void DeltaStepping::run(size_t from, size_t to) {
+        m_rounds = 0;
+        const size_t nodes = m_graph.node_count();
+        m_pool.parallel_for(nodes, 1 << 16, [&](size_t begin, size_t end, size_t) {
+            for (size_t node = begin; node < end; ++node) {
+                m_heat[node].store(AxisGraph::UNREACHABLE, std::memory_order_relaxed);
+            }
+        });
+        for (auto &bucket: m_buckets) {
+            bucket.clear();
+        }
+        m_queued = 0;
+        if (from >= m_graph.width() * m_graph.height() || !m_graph.valid_rules()) {
+            return;
+        }
+        for (const auto axis: {Axis::HORIZONTAL, Axis::VERTICAL}) {
+            m_heat[AxisGraph::node_of(from, axis)].store(0, std::memory_order_relaxed);
+            m_buckets[0].push_back(AxisGraph::node_of(from, axis));
+            ++m_queued;
+        }
+
+        const auto target_heat = [&] {
+            if (to == SIZE_MAX) {
+                return AxisGraph::UNREACHABLE;
+            }
+            return std::min(m_heat[AxisGraph::node_of(to, Axis::HORIZONTAL)].load(std::memory_order_relaxed),
+                            m_heat[AxisGraph::node_of(to, Axis::VERTICAL)].load(std::memory_order_relaxed));
+        };
+
+        std::vector<uint32_t> frontier;
+        std::vector<uint32_t> settled;
+        for (size_t current = 0; m_queued > 0; ++current) {
+            auto &bucket = m_buckets[current % m_buckets.size()];
+            if (bucket.empty()) {
+                continue;
+            }
+            // light jumps may lead back into this bucket, so we go on until it stays empty
+            settled.clear();
+            while (!bucket.empty()) {
+                m_queued -= bucket.size();
+                frontier.clear();
+                const uint16_t taken_round = next_round();
+                for (const auto node: bucket) {
+                    // entries of nodes that were lowered into an earlier bucket since, or are in here twice
+                    if (m_heat[node].load(std::memory_order_relaxed) / m_delta != current ||
+                        m_stamp[node] == taken_round) {
+                        continue;
+                    }
+                    m_stamp[node] = taken_round;
+                    frontier.push_back(node);
+                }
+                bucket.clear();
+                for (const auto node: frontier) {
+                    settled.push_back(node);
+                }
+                relax(frontier, true);
+                collect();
+            }
+            // a node may have been taken more than once while its heat went down
+            std::sort(settled.begin(), settled.end());
+            settled.erase(std::unique(settled.begin(), settled.end()), settled.end());
+            relax(settled, false);
+            collect();
+
+            // everything below the next bucket is final now
+            if (target_heat() / m_delta <= current) {
+                return;
+            }
+        }
+    }
+
+    std::vector<uint32_t> DeltaStepping::heat_map(size_t from) {
+        const size_t fields = m_graph.width() * m_graph.height();
+        run(from, SIZE_MAX);
+        std::vector<uint32_t> result(fields, AxisGraph::UNREACHABLE);
+        if (from >= fields || !m_graph.valid_rules()) {
+            return result;
+        }
+        m_pool.parallel_for(fields, 1 << 16, [&](size_t begin, size_t end, size_t) {
+            for (size_t field = begin; field < end; ++field) {
+                result[field] = std::min(m_heat[AxisGraph::node_of(field, Axis::HORIZONTAL)].load(),
+                                         m_heat[AxisGraph::node_of(field, Axis::VERTICAL)].load());
+            }
+        });
+        return result;
+    }
+
+    uint32_t DeltaStepping::min_heat_loss(size_t from, size_t to) {
+        const size_t fields = m_graph.width() * m_graph.height();
+        if (from >= fields || to >= fields || !m_graph.valid_rules()) {
+            return AxisGraph::UNREACHABLE;
+        }
+        run(from, to);
+        return std::min(m_heat[AxisGraph::node_of(to, Axis::HORIZONTAL)].load(),
+                        m_heat[AxisGraph::node_of(to, Axis::VERTICAL)].load());
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef AOC2024_DAY17_DELTA_STEPPING_H
+#define AOC2024_DAY17_DELTA_STEPPING_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "axis_graph.h"
+#include "../../utils/thread_pool.h"
+
+namespace aoc2024::day17 {
+
+    /***
+     * @brief Parallel shortest paths on an [AxisGraph] (delta-stepping)
+     *
+     * Nodes are kept in buckets of `delta` heat. The nodes of the lowest bucket relax their light jumps (heat <=
+     * delta) in parallel, lowering the heat of their neighbours with an atomic min, until the bucket stays empty;
+     * then its nodes relax their heavy jumps once. Heats are exact, so the results are the same as the serial
+     * search of the graph (UNREACHABLE everywhere for invalid rules, like there).
+     */
+    class DeltaStepping {
+    public:
+        /***
+         * @param graph
+         * @param pool
+         * @param delta bucket width; 0 picks one from the rules of the graph
+         */
+        DeltaStepping(const AxisGraph &graph, utils::ThreadPool &pool, uint32_t delta = 0);
+
+        [[nodiscard]] uint32_t delta() const {
+            return m_delta;
+        }
+
+        /***
+         * @brief Same as [AxisGraph::heat_map]
+         */
+        [[nodiscard]] std::vector<uint32_t> heat_map(size_t from);
+
+        /***
+         * @brief Same as [AxisGraph::min_heat_loss], stops after the bucket that settles `to`
+         */
+        [[nodiscard]] uint32_t min_heat_loss(size_t from, size_t to);
+
+        /***
+         * @brief number of parallel rounds (light or heavy relaxations of a bucket) the last search took
+         */
+        [[nodiscard]] size_t last_rounds() const {
+            return m_rounds;
+        }
+
+    private:
+        /***
+         * @brief runs the search from `from`, stopping once `to` is settled (never if `to` is SIZE_MAX)
+         */
+        void run(size_t from, size_t to);
+
+        /***
+         * @brief relaxes the light or heavy jumps of `nodes` in parallel, the lowered nodes go to m_lowered
+         */
+        void relax(const std::vector<uint32_t> &nodes, bool light);
+
+        /***
+         * @brief puts the lowered nodes into their buckets (each at most once per call)
+         */
+        void collect();
+
+        /***
+         * @brief starts a new round of m_stamp
+         */
+        uint16_t next_round();
+
+        const AxisGraph &m_graph;
+        utils::ThreadPool &m_pool;
+        uint32_t m_delta;
+
+        std::unique_ptr<std::atomic<uint32_t>[]> m_heat;
+
+        /// ring of buckets, big enough for the heaviest jump from the current bucket
+        std::vector<std::vector<uint32_t>> m_buckets;
+        size_t m_queued = 0;
+
+        /// nodes lowered by each worker in the current round
+        std::vector<std::vector<uint32_t>> m_lowered;
+
+        /// stamp per node so it is queued / taken only once per round (cleared when the round number wraps around)
+        std::vector<uint16_t> m_stamp;
+        uint16_t m_round = 0;
+        size_t m_rounds = 0;
+    };
+}
+
+#endif //AOC2024_DAY17_DELTA_STEPPING_H
@@ -0,0 +1,52 @@
+#ifndef AOC2024_BENCH_UTILS_H
+#define AOC2024_BENCH_UTILS_H
+
+#include <chrono>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace aoc2024::utils {
+
+    /***
+     * @brief Runs `fn` once and returns how long it took in milliseconds
+     * @param fn
+     * @return
+     */
+    template<typename Fn>
+    double time_ms(Fn &&fn) {
+        const auto start = std::chrono::steady_clock::now();
+        fn();
+        const auto end = std::chrono::steady_clock::now();
+        return std::chrono::duration<double, std::milli>(end - start).count();
+    }
+
+    /***
+     * @brief Builds a random grid (line by line, like [read_file_lines] would return it)
+     *
+     * Every cell is picked from `alphabet` using the given `weights` (same length as `alphabet`).
+     * The same `seed` always gives the same grid so engines can be compared against each other.
+     *
+     * @param width
+     * @param height
+     * @param alphabet
+     * @param weights
+     * @param seed
+     * @return
+     */
+    inline std::vector<std::string> random_grid(size_t width, size_t height, const std::string &alphabet,
+                                                const std::vector<double> &weights, uint64_t seed = 42) {
+        std::mt19937_64 rng(seed);
+        std::discrete_distribution<size_t> pick(weights.begin(), weights.end());
+        std::vector<std::string> lines(height, std::string(width, alphabet[0]));
+        for (auto &line: lines) {
+            for (auto &chr: line) {
+                chr = alphabet[pick(rng)];
+            }
+        }
+        return lines;
+    }
+}
+
+#endif //AOC2024_BENCH_UTILS_H
@@ -0,0 +1,102 @@
+#ifndef AOC2024_UTILS_BIT_LINE_H
+#define AOC2024_UTILS_BIT_LINE_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+
+/***
+ * Helpers to work on lines of cells stored as bits in `uint64_t` words (bit `i` of the line
+ * is bit `i % 64` of word `i / 64`)
+ */
+namespace aoc2024::utils::bits {
+    constexpr size_t WORD_BITS = 64;
+
+    /***
+     * @brief mask of the bits [from, to) inside of one word (0 <= from <= to <= 64)
+     */
+    inline uint64_t word_mask(size_t from, size_t to) {
+        const uint64_t upper = to >= WORD_BITS ? ~uint64_t{0} : (uint64_t{1} << to) - 1;
+        const uint64_t lower = (uint64_t{1} << from) - 1;
+        return upper & ~lower;
+    }
+
+    /***
+     * @brief index of the next set bit in [from, n) or `n` if there is none
+     */
+    inline size_t next_set_bit(const uint64_t *words, size_t from, size_t n) {
+        size_t w = from / WORD_BITS;
+        const size_t last_word = (n + WORD_BITS - 1) / WORD_BITS;
+        if (w >= last_word) {
+            return n;
+        }
+        uint64_t word = words[w] & ~((uint64_t{1} << (from % WORD_BITS)) - 1);
+        while (true) {
+            if (word != 0) {
+                return std::min(n, w * WORD_BITS + std::countr_zero(word));
+            }
+            if (++w >= last_word) {
+                return n;
+            }
+            word = words[w];
+        }
+    }
+
+    /***
+     * @brief index of the last set bit in [from, to) or `to` if there is none
+     */
+    inline size_t prev_set_bit(const uint64_t *words, size_t from, size_t to) {
+        if (from >= to) {
+            return to;
+        }
+        size_t w = (to - 1) / WORD_BITS;
+        uint64_t word = words[w] & word_mask(0, (to - 1) % WORD_BITS + 1);
+        while (true) {
+            if (word != 0) {
+                const size_t found = w * WORD_BITS + WORD_BITS - 1 - std::countl_zero(word);
+                return found >= from ? found : to;
+            }
+            if (w == 0 || (w - 1) * WORD_BITS + WORD_BITS <= from) {
+                return to;
+            }
+            word = words[--w];
+        }
+    }
+
+    /***
+     * @brief calls `fn(first_word, from_bit, to_bit)` for every word touched by [from, to)
+     */
+    template<typename Fn>
+    inline void for_each_word(size_t from, size_t to, Fn &&fn) {
+        while (from < to) {
+            const size_t w = from / WORD_BITS;
+            const size_t bit = from % WORD_BITS;
+            const size_t end = std::min(to - w * WORD_BITS, WORD_BITS);
+            fn(w, bit, end);
+            from = w * WORD_BITS + end;
+        }
+    }
+
+    inline size_t count_bits(const uint64_t *words, size_t from, size_t to) {
+        size_t count = 0;
+        for_each_word(from, to, [&](size_t w, size_t a, size_t b) {
+            count += std::popcount(words[w] & word_mask(a, b));
+        });
+        return count;
+    }
+
+    inline void clear_bits(uint64_t *words, size_t from, size_t to) {
+        for_each_word(from, to, [&](size_t w, size_t a, size_t b) {
+            words[w] &= ~word_mask(a, b);
+        });
+    }
+
+    inline void set_bits(uint64_t *words, size_t from, size_t to) {
+        for_each_word(from, to, [&](size_t w, size_t a, size_t b) {
+            words[w] |= word_mask(a, b);
+        });
+    }
+}
+
+#endif //AOC2024_UTILS_BIT_LINE_H
@@ -22,7 +22,7 @@ namespace aoc2024::utils {
         return lines;
     }
 
-    std::vector<std::string> load_day(size_t day, RIDDLE_TYPE type) {
+    std::string day_path(size_t day, RIDDLE_TYPE type) {
         std::string path = BASE;
         path += "/days/day";
         path += std::to_string(day);
@@ -35,6 +35,10 @@ namespace aoc2024::utils {
                 path += "in_task.txt";
                 break;
         }
-        return read_file_lines(path);
+        return path;
+    }
+
+    std::vector<std::string> load_day(size_t day, RIDDLE_TYPE type) {
+        return read_file_lines(day_path(day, type));
     }
 }
@@ -12,6 +12,7 @@ namespace aoc2024::utils {
         TASK,
     };
     std::vector<std::string> read_file_lines(const std::string_view& path);
+    std::string day_path(size_t day, RIDDLE_TYPE type);
     std::vector<std::string> load_day(size_t day, RIDDLE_TYPE type);
 }
 #endif //AOC2024_FILE_UTILS_H
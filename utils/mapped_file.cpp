@@ -0,0 +1,147 @@
+#include "mapped_file.h"
+#include <iostream>
+#include <utility>
+
+#if defined(__unix__) || defined(__APPLE__)
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace aoc2024::utils {
+    namespace {
+        /***
+         * @brief maps `size` bytes of `fd` (an empty file gets no mapping, mmap does not like size 0)
+         */
+        uint8_t *map(int fd, size_t size, bool writable) {
+            if (size == 0) {
+                return nullptr;
+            }
+            void *data = mmap(nullptr, size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_SHARED, fd, 0);
+            return data == MAP_FAILED ? nullptr : static_cast<uint8_t *>(data);
+        }
+    }
+
+    std::optional<MappedFile> MappedFile::open(const std::string &path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            std::cerr << "Could not open " << path << std::endl;
+            return std::nullopt;
+        }
+        struct stat info{};
+        if (fstat(fd, &info) != 0) {
+            std::cerr << "Could not stat " << path << std::endl;
+            ::close(fd);
+            return std::nullopt;
+        }
+        const auto size = static_cast<size_t>(info.st_size);
+        uint8_t *data = map(fd, size, false);
+        if (size > 0 && data == nullptr) {
+            std::cerr << "Could not map " << path << std::endl;
+            ::close(fd);
+            return std::nullopt;
+        }
+        return MappedFile(fd, data, size, false);
+    }
+
+    std::optional<MappedFile> MappedFile::create(const std::string &path, size_t size) {
+        const int fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) {
+            std::cerr << "Could not create " << path << std::endl;
+            return std::nullopt;
+        }
+        if (ftruncate(fd, static_cast<off_t>(size)) != 0) {
+            std::cerr << "Could not grow " << path << " to " << size << " bytes" << std::endl;
+            ::close(fd);
+            return std::nullopt;
+        }
+        uint8_t *data = map(fd, size, true);
+        if (size > 0 && data == nullptr) {
+            std::cerr << "Could not map " << path << std::endl;
+            ::close(fd);
+            return std::nullopt;
+        }
+        return MappedFile(fd, data, size, true);
+    }
+
+    bool MappedFile::resize(size_t size) {
+        if (!m_writable || m_fd < 0) {
+            return false;
+        }
+        if (m_data != nullptr) {
+            munmap(m_data, m_size);
+            m_data = nullptr;
+        }
+        if (ftruncate(m_fd, static_cast<off_t>(size)) != 0) {
+            m_size = 0;
+            return false;
+        }
+        m_data = map(m_fd, size, true);
+        m_size = m_data != nullptr ? size : 0;
+        return size == 0 || m_data != nullptr;
+    }
+
+    void MappedFile::close() {
+        if (m_data != nullptr) {
+            munmap(m_data, m_size);
+        }
+        if (m_fd >= 0) {
+            ::close(m_fd);
+        }
+        m_data = nullptr;
+        m_size = 0;
+        m_fd = -1;
+    }
+}
+
+#else
+
+namespace aoc2024::utils {
+    std::optional<MappedFile> MappedFile::open(const std::string &path) {
+        std::cerr << "Memory mapped files are not supported on this platform (" << path << ")" << std::endl;
+        return std::nullopt;
+    }
+
+    std::optional<MappedFile> MappedFile::create(const std::string &path, size_t) {
+        std::cerr << "Memory mapped files are not supported on this platform (" << path << ")" << std::endl;
+        return std::nullopt;
+    }
+
+    bool MappedFile::resize(size_t) {
+        return false;
+    }
+
+    void MappedFile::close() {
+    }
+}
+
+#endif
+
+namespace aoc2024::utils {
+    MappedFile::MappedFile(int fd, uint8_t *data, size_t size, bool writable)
+            : m_fd(fd), m_data(data), m_size(size), m_writable(writable) {
+    }
+
+    MappedFile::MappedFile(MappedFile &&other) noexcept
+            : m_fd(std::exchange(other.m_fd, -1)),
+              m_data(std::exchange(other.m_data, nullptr)),
+              m_size(std::exchange(other.m_size, 0)),
+              m_writable(other.m_writable) {
+    }
+
+    MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+        if (this != &other) {
+            close();
+            m_fd = std::exchange(other.m_fd, -1);
+            m_data = std::exchange(other.m_data, nullptr);
+            m_size = std::exchange(other.m_size, 0);
+            m_writable = other.m_writable;
+        }
+        return *this;
+    }
+
+    MappedFile::~MappedFile() {
+        close();
+    }
+}
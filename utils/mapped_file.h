@@ -0,0 +1,81 @@
+#ifndef AOC2024_MAPPED_FILE_H
+#define AOC2024_MAPPED_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+namespace aoc2024::utils {
+
+    /***
+     * @brief A file mapped into memory (POSIX `mmap`)
+     *
+     * Either read only ([open]) or read / write ([create]), in which case it can grow with [resize]
+     * and everything written to [data] ends up in the file. On other platforms [open] and [create] fail.
+     */
+    class MappedFile {
+    public:
+        /***
+         * @brief Maps an existing file read only
+         * @param path
+         * @return nullopt (and a message on stderr) if the file can not be mapped
+         */
+        static std::optional<MappedFile> open(const std::string &path);
+
+        /***
+         * @brief Creates (or truncates) a file of `size` bytes and maps it writable
+         * @param path
+         * @param size
+         * @return nullopt (and a message on stderr) if the file can not be created
+         */
+        static std::optional<MappedFile> create(const std::string &path, size_t size);
+
+        MappedFile(MappedFile &&other) noexcept;
+
+        MappedFile &operator=(MappedFile &&other) noexcept;
+
+        MappedFile(const MappedFile &) = delete;
+
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        ~MappedFile();
+
+        [[nodiscard]] const uint8_t *data() const {
+            return m_data;
+        }
+
+        /***
+         * @brief writable memory of the file (nullptr if it was opened read only)
+         */
+        [[nodiscard]] uint8_t *mutable_data() {
+            return m_writable ? m_data : nullptr;
+        }
+
+        [[nodiscard]] size_t size() const {
+            return m_size;
+        }
+
+        /***
+         * @brief Changes the size of a writable file; [data] may move
+         * @param size
+         * @return false if the file is read only or could not be resized
+         */
+        bool resize(size_t size);
+
+        /***
+         * @brief Unmaps the file (done by the destructor as well)
+         */
+        void close();
+
+    private:
+        MappedFile(int fd, uint8_t *data, size_t size, bool writable);
+
+        int m_fd = -1;
+        uint8_t *m_data = nullptr;
+        size_t m_size = 0;
+        bool m_writable = false;
+    };
+}
+
+#endif //AOC2024_MAPPED_FILE_H
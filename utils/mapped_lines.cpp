@@ -0,0 +1,31 @@
+#include "mapped_lines.h"
+#include <cstring>
+
+namespace aoc2024::utils {
+    MappedLines::MappedLines(MappedFile file) : m_file(std::move(file)) {
+        const char *data = reinterpret_cast<const char *>(m_file.data());
+        const size_t size = m_file.size();
+        for (size_t pos = 0; pos < size;) {
+            const void *newline = std::memchr(data + pos, '\n', size - pos);
+            const size_t end = newline != nullptr ? static_cast<const char *>(newline) - data : size;
+            std::string_view line(data + pos, end - pos);
+            if (!line.empty() && line.back() == '\r') {
+                line.remove_suffix(1);
+            }
+            m_lines.push_back(line);
+            pos = end + 1;
+        }
+    }
+
+    std::optional<MappedLines> MappedLines::open(const std::string &path) {
+        auto file = MappedFile::open(path);
+        if (!file) {
+            return std::nullopt;
+        }
+        return MappedLines(std::move(*file));
+    }
+
+    std::optional<MappedLines> map_day(size_t day, RIDDLE_TYPE type) {
+        return MappedLines::open(day_path(day, type));
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef AOC2024_MAPPED_LINES_H
+#define AOC2024_MAPPED_LINES_H
+
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "file_utils.h"
+#include "mapped_file.h"
+
+namespace aoc2024::utils {
+
+    /***
+     * @brief The lines of a file mapped into memory, without copying them
+     *
+     * Same lines as [read_file_lines] (without the line breaks, a trailing '\r' is dropped as well), but every line
+     * is a view into the [MappedFile]: nothing is allocated per line and the parsers (e.g. `Field::parse`) read
+     * straight from the page cache. The views are valid as long as the object lives (moving it keeps them valid).
+     */
+    class MappedLines {
+    public:
+        /***
+         * @param path
+         * @return nullopt (and a message on stderr) if the file can not be mapped
+         */
+        static std::optional<MappedLines> open(const std::string &path);
+
+        [[nodiscard]] std::span<const std::string_view> lines() const {
+            return m_lines;
+        }
+
+        /***
+         * @brief size of the mapped file in bytes
+         */
+        [[nodiscard]] size_t bytes() const {
+            return m_file.size();
+        }
+
+    private:
+        explicit MappedLines(MappedFile file);
+
+        MappedFile m_file;
+        std::vector<std::string_view> m_lines;
+    };
+
+    /***
+     * @brief Same as [load_day], mapped instead of read
+     */
+    std::optional<MappedLines> map_day(size_t day, RIDDLE_TYPE type);
+}
+
+#endif //AOC2024_MAPPED_LINES_H
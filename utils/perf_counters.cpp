@@ -0,0 +1,85 @@
+#include "perf_counters.h"
+
+#ifdef __linux__
+
+#include <cstring>
+#include <initializer_list>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace aoc2024::utils {
+    namespace {
+        int open_counter(uint32_t type, uint64_t config) {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = type;
+            attr.config = config;
+            attr.disabled = 1;
+            attr.inherit = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+        }
+
+        uint64_t read_counter(int fd) {
+            uint64_t value = 0;
+            if (fd < 0 || read(fd, &value, sizeof(value)) != sizeof(value)) {
+                return 0;
+            }
+            return value;
+        }
+    }
+
+    PerfCounters::PerfCounters() {
+        m_l1_fd = open_counter(PERF_TYPE_HW_CACHE,
+                               PERF_COUNT_HW_CACHE_L1D |
+                               (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                               (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+        m_llc_fd = open_counter(PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES);
+    }
+
+    PerfCounters::~PerfCounters() {
+        if (m_l1_fd >= 0) {
+            close(m_l1_fd);
+        }
+        if (m_llc_fd >= 0) {
+            close(m_llc_fd);
+        }
+    }
+
+    void PerfCounters::start() {
+        for (const int fd: {m_l1_fd, m_llc_fd}) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+        }
+    }
+
+    void PerfCounters::stop() {
+        for (const int fd: {m_l1_fd, m_llc_fd}) {
+            if (fd >= 0) {
+                ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+            }
+        }
+        m_l1_misses = read_counter(m_l1_fd);
+        m_llc_misses = read_counter(m_llc_fd);
+    }
+}
+
+#else
+
+namespace aoc2024::utils {
+    PerfCounters::PerfCounters() = default;
+
+    PerfCounters::~PerfCounters() = default;
+
+    void PerfCounters::start() {}
+
+    void PerfCounters::stop() {}
+}
+
+#endif
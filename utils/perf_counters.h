@@ -0,0 +1,50 @@
+#ifndef AOC2024_PERF_COUNTERS_H
+#define AOC2024_PERF_COUNTERS_H
+
+#include <cstdint>
+
+namespace aoc2024::utils {
+
+    /***
+     * @brief Hardware cache miss counters of this process (Linux `perf_event_open`)
+     *
+     * Counts L1 data cache read misses and last level cache misses between [start] and [stop].
+     * Threads created *after* the counters are inherited, so create the counters before a [ThreadPool].
+     * On other platforms (or without permission, see `perf_event_paranoid`) [available] is false
+     * and all counts stay 0.
+     */
+    class PerfCounters {
+    public:
+        PerfCounters();
+
+        ~PerfCounters();
+
+        PerfCounters(const PerfCounters &) = delete;
+
+        PerfCounters &operator=(const PerfCounters &) = delete;
+
+        [[nodiscard]] bool available() const {
+            return m_l1_fd >= 0 && m_llc_fd >= 0;
+        }
+
+        void start();
+
+        void stop();
+
+        [[nodiscard]] uint64_t l1_misses() const {
+            return m_l1_misses;
+        }
+
+        [[nodiscard]] uint64_t llc_misses() const {
+            return m_llc_misses;
+        }
+
+    private:
+        int m_l1_fd = -1;
+        int m_llc_fd = -1;
+        uint64_t m_l1_misses = 0;
+        uint64_t m_llc_misses = 0;
+    };
+}
+
+#endif //AOC2024_PERF_COUNTERS_H
@@ -0,0 +1,84 @@
+#include "thread_pool.h"
+#include <algorithm>
+
+namespace aoc2024::utils {
+    ThreadPool::ThreadPool(size_t threads) {
+        if (threads == 0) {
+            threads = std::max<size_t>(1, std::thread::hardware_concurrency());
+        }
+        for (size_t worker = 1; worker < threads; ++worker) {
+            m_workers.emplace_back([this, worker] { worker_loop(worker); });
+        }
+    }
+
+    ThreadPool::~ThreadPool() {
+        {
+            std::lock_guard lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (auto &thread: m_workers) {
+            thread.join();
+        }
+    }
+
+    void ThreadPool::run_chunks(size_t worker) {
+        while (true) {
+            const size_t begin = m_next.fetch_add(m_grain);
+            if (begin >= m_count) {
+                return;
+            }
+            (*m_fn)(begin, std::min(m_count, begin + m_grain), worker);
+        }
+    }
+
+    void ThreadPool::worker_loop(size_t worker) {
+        size_t seen_generation = 0;
+        while (true) {
+            {
+                std::unique_lock lock(m_mutex);
+                m_wake.wait(lock, [&] { return m_stop || m_generation != seen_generation; });
+                if (m_stop) {
+                    return;
+                }
+                seen_generation = m_generation;
+            }
+            run_chunks(worker);
+            {
+                std::lock_guard lock(m_mutex);
+                if (--m_busy == 0) {
+                    m_done.notify_one();
+                }
+            }
+        }
+    }
+
+    void ThreadPool::parallel_for(size_t count, size_t grain, const RangeFn &fn) {
+        if (count == 0) {
+            return;
+        }
+        grain = std::max<size_t>(1, grain);
+        if (m_workers.empty() || count <= grain) {
+            fn(0, count, 0);
+            return;
+        }
+
+        {
+            std::lock_guard lock(m_mutex);
+            m_fn = &fn;
+            m_count = count;
+            m_grain = grain;
+            m_next = 0;
+            m_busy = m_workers.size();
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        // the calling thread helps out
+        run_chunks(0);
+
+        std::unique_lock lock(m_mutex);
+        m_done.wait(lock, [&] { return m_busy == 0; });
+        m_fn = nullptr;
+    }
+}
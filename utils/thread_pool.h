@@ -0,0 +1,77 @@
+#ifndef AOC2024_THREAD_POOL_H
+#define AOC2024_THREAD_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace aoc2024::utils {
+
+    /***
+     * @brief A fixed set of worker threads to split loops over
+     *
+     * The calling thread takes part in the work as worker `0`, so a pool of size 1 has no extra thread
+     * and simply runs everything inline.
+     */
+    class ThreadPool {
+    public:
+        /// called with a range [begin, end) and the index of the worker (0 <= worker < size())
+        using RangeFn = std::function<void(size_t begin, size_t end, size_t worker)>;
+
+        /***
+         * @param threads number of workers (including the calling thread); 0 means one per core
+         */
+        explicit ThreadPool(size_t threads = 0);
+
+        ~ThreadPool();
+
+        ThreadPool(const ThreadPool &) = delete;
+
+        ThreadPool &operator=(const ThreadPool &) = delete;
+
+        [[nodiscard]] size_t size() const {
+            return m_workers.size() + 1;
+        }
+
+        /***
+         * @brief Runs `fn` over [0, count) in chunks of `grain` items and blocks until all are done
+         *
+         * Workers grab the next chunk as soon as they are done with their last one,
+         * so uneven chunks balance themselves.
+         *
+         * @param count
+         * @param grain
+         * @param fn
+         */
+        void parallel_for(size_t count, size_t grain, const RangeFn &fn);
+
+    private:
+        void worker_loop(size_t worker);
+
+        void run_chunks(size_t worker);
+
+        std::vector<std::thread> m_workers;
+        std::mutex m_mutex;
+        std::condition_variable m_wake;
+        std::condition_variable m_done;
+
+        /// current job (only valid while `m_busy > 0`)
+        const RangeFn *m_fn = nullptr;
+        size_t m_count = 0;
+        size_t m_grain = 1;
+        std::atomic<size_t> m_next{0};
+
+        /// bumped for every job so workers know there is something new
+        size_t m_generation = 0;
+
+        /// number of extra workers still working on the current job
+        size_t m_busy = 0;
+        bool m_stop = false;
+    };
+}
+
+#endif //AOC2024_THREAD_POOL_H